@@ -1,7 +1,11 @@
 extends CircuitSimulator
 
 func _ready():
-	if initialize_ngspice():
-		print("ngspice ready!")
-	else:
+	ngspice_ready.connect(_on_ngspice_ready)
+	# Library load and ngSpice_Init run on a worker thread, so the first
+	# frame is not stalled; calls made before ngspice_ready are queued
+	if not initialize_ngspice_async():
 		print("Failed to initialize ngspice")
+
+func _on_ngspice_ready():
+	print("ngspice ready!")
@@ -1,23 +1,59 @@
 #include "circuit_sim.h"
-
+#include "graph_layout.h"
+#include "netlist_includes.h"
+#include "sim_snapshot.h"
+#include "sim_vector.h"
+#include "sim_worker_pool.h"
+
+#include <godot_cpp/classes/file_access.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
 #include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/callable_method_pointer.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <vector>
 #include <string>
 
 using namespace godot;
 
-// Static instance for callbacks
-CircuitSimulator* CircuitSimulator::instance = nullptr;
+// Probe names and streamed vector names are matched on a common key:
+// "v(out)" and "out" -> "out", "i(v1)" and "v1#branch" -> "v1#branch"
+std::string CircuitSimulator::probe_key(const char *name) {
+    std::string key(name);
+    for (char &c : key) {
+        c = (char)tolower((unsigned char)c);
+    }
+    if (key.size() > 3 && key[1] == '(' && key.back() == ')') {
+        if (key[0] == 'v') {
+            key = key.substr(2, key.size() - 3);
+        } else if (key[0] == 'i') {
+            key = key.substr(2, key.size() - 3) + "#branch";
+        }
+    }
+    return key;
+}
 
-// Callback functions for ngspice
+// Callback functions for ngspice. Every instance passes itself as
+// user_data, so each callback reaches the simulator that owns the library.
 static int ng_send_char(char *output, int id, void *user_data) {
-    if (CircuitSimulator::instance) {
-        CircuitSimulator::instance->emit_signal("ngspice_output", String(output));
+    // One conversion, shared by the signal and the console
+    CircuitSimulator *sim = static_cast<CircuitSimulator*>(user_data);
+    if (sim) {
+        sim->handle_output(output);
+        if (sim->defer_init_output(output)) {
+            return 0;
+        }
     }
-    UtilityFunctions::print(String("[ngspice] ") + String(output));
+    String text(output);
+    if (sim) {
+        sim->emit_signal("ngspice_output", text);
+    }
+    UtilityFunctions::print("[ngspice] ", text);
     return 0;
 }
 
@@ -33,13 +69,9 @@ static int ng_controlled_exit(int status, bool immediate, bool exit_on_quit, int
 
 static int ng_send_data(pvecvaluesall data, int count, int id, void *user_data) {
     // Called during simulation with new data points
-    if (CircuitSimulator::instance) {
-        Dictionary dict;
-        for (int i = 0; i < data->veccount; i++) {
-            pvecvalues vec = data->vecsa[i];
-            dict[String(vec->name)] = vec->creal;
-        }
-        CircuitSimulator::instance->emit_signal("simulation_data_ready", dict);
+    CircuitSimulator *sim = static_cast<CircuitSimulator*>(user_data);
+    if (sim) {
+        sim->handle_send_data(data);
     }
     return 0;
 }
@@ -47,15 +79,20 @@ static int ng_send_data(pvecvaluesall data, int count, int id, void *user_data)
 static int ng_send_init_data(pvecinfoall data, int id, void *user_data) {
     // Called before simulation with vector info
     UtilityFunctions::print(String("Simulation initialized with ") + String::num_int64(data->veccount) + " vectors");
+    CircuitSimulator *sim = static_cast<CircuitSimulator*>(user_data);
+    if (sim) {
+        sim->handle_init_data(data);
+    }
     return 0;
 }
 
 static int ng_bg_thread_running(bool running, int id, void *user_data) {
-    if (CircuitSimulator::instance) {
+    CircuitSimulator *sim = static_cast<CircuitSimulator*>(user_data);
+    if (sim) {
         if (running) {
-            CircuitSimulator::instance->emit_signal("simulation_started");
+            sim->emit_signal("simulation_started");
         } else {
-            CircuitSimulator::instance->emit_signal("simulation_finished");
+            sim->emit_signal("simulation_finished");
         }
     }
     return 0;
@@ -63,8 +100,19 @@ static int ng_bg_thread_running(bool running, int id, void *user_data) {
 
 // Callback for interactive voltage source control
 static int ng_get_vsrc_data(double *voltage, double time, char *node_name, int id, void *user_data) {
-    if (CircuitSimulator::instance) {
-        *voltage = CircuitSimulator::instance->get_voltage_source(String(node_name));
+    CircuitSimulator *sim = static_cast<CircuitSimulator*>(user_data);
+    if (sim) {
+        *voltage = sim->resolve_voltage_source(node_name, time);
+    }
+    return 0;
+}
+
+// Called around every transient step while convergence tracing is on;
+// delta is left alone, so the solver behaves as without the callback
+static int ng_get_sync_data(double time, double *delta, double old_delta, int redo_step, int id, int location, void *user_data) {
+    CircuitSimulator *sim = static_cast<CircuitSimulator*>(user_data);
+    if (sim) {
+        sim->handle_sync(time, old_delta, location);
     }
     return 0;
 }
@@ -74,6 +122,9 @@ void CircuitSimulator::_bind_methods() {
     ClassDB::bind_method(D_METHOD("initialize_ngspice"), &CircuitSimulator::initialize_ngspice);
     ClassDB::bind_method(D_METHOD("shutdown_ngspice"), &CircuitSimulator::shutdown_ngspice);
     ClassDB::bind_method(D_METHOD("is_initialized"), &CircuitSimulator::is_initialized);
+    ClassDB::bind_method(D_METHOD("initialize_ngspice_async", "skip_spinit", "code_models"), &CircuitSimulator::initialize_ngspice_async, DEFVAL(false), DEFVAL(PackedStringArray()));
+    ClassDB::bind_method(D_METHOD("is_initializing"), &CircuitSimulator::is_initializing);
+    ClassDB::bind_method(D_METHOD("_finish_async_init", "success", "generation"), &CircuitSimulator::_finish_async_init);
 
     // Circuit loading
     ClassDB::bind_method(D_METHOD("load_netlist", "netlist_path"), &CircuitSimulator::load_netlist);
@@ -86,6 +137,45 @@ void CircuitSimulator::_bind_methods() {
     ClassDB::bind_method(D_METHOD("run_dc", "source", "start", "stop", "step"), &CircuitSimulator::run_dc);
     ClassDB::bind_method(D_METHOD("stop_simulation"), &CircuitSimulator::stop_simulation);
     ClassDB::bind_method(D_METHOD("is_running"), &CircuitSimulator::is_running);
+    ClassDB::bind_method(D_METHOD("set_worker_backend", "enabled", "executable_path", "library_path", "timeout"), &CircuitSimulator::set_worker_backend, DEFVAL(""), DEFVAL(""), DEFVAL(0.0));
+    ClassDB::bind_method(D_METHOD("is_worker_backend"), &CircuitSimulator::is_worker_backend);
+    ClassDB::bind_method(D_METHOD("run_transient_resumable", "step", "stop", "horizon", "start"), &CircuitSimulator::run_transient_resumable, DEFVAL(0.0));
+    ClassDB::bind_method(D_METHOD("extend_transient", "new_stop"), &CircuitSimulator::extend_transient);
+    ClassDB::bind_method(D_METHOD("pause_simulation"), &CircuitSimulator::pause_simulation);
+    ClassDB::bind_method(D_METHOD("resume_simulation"), &CircuitSimulator::resume_simulation);
+    ClassDB::bind_method(D_METHOD("get_transient_stop"), &CircuitSimulator::get_transient_stop);
+    ClassDB::bind_method(D_METHOD("get_transient_horizon"), &CircuitSimulator::get_transient_horizon);
+
+    // Probes
+    ClassDB::bind_method(D_METHOD("set_probes", "probe_names"), &CircuitSimulator::set_probes);
+    ClassDB::bind_method(D_METHOD("get_probes"), &CircuitSimulator::get_probes);
+    ClassDB::bind_method(D_METHOD("clear_probes"), &CircuitSimulator::clear_probes);
+
+    // Operating point
+    ClassDB::bind_method(D_METHOD("run_operating_point", "warm_start"), &CircuitSimulator::run_operating_point, DEFVAL(true));
+    ClassDB::bind_method(D_METHOD("alter_component", "device", "value", "parameter"), &CircuitSimulator::alter_component, DEFVAL(""));
+
+    // Sweeps
+    ClassDB::bind_method(D_METHOD("run_sweep", "axes", "outputs"), &CircuitSimulator::run_sweep);
+
+    // Netlist topology
+    ClassDB::bind_method(D_METHOD("get_netlist_graph"), &CircuitSimulator::get_netlist_graph);
+    ClassDB::bind_method(D_METHOD("layout_netlist_graph", "iterations", "spacing", "thread_count", "include_ground"), &CircuitSimulator::layout_netlist_graph, DEFVAL(100), DEFVAL(64.0), DEFVAL(0), DEFVAL(false));
+
+    // Spectrum analysis
+    ClassDB::bind_method(D_METHOD("get_spectrum", "vector_name", "points", "window", "t0", "t1"), &CircuitSimulator::get_spectrum, DEFVAL(0), DEFVAL(WINDOW_HANN), DEFVAL(0.0), DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("get_spectra", "vector_names", "points", "window", "t0", "t1", "thread_count"), &CircuitSimulator::get_spectra, DEFVAL(0), DEFVAL(WINDOW_HANN), DEFVAL(0.0), DEFVAL(-1.0), DEFVAL(0));
+    ClassDB::bind_method(D_METHOD("get_spectrogram", "vector_name", "frame_size", "hop", "window", "points", "thread_count"), &CircuitSimulator::get_spectrogram, DEFVAL(1024), DEFVAL(256), DEFVAL(WINDOW_HANN), DEFVAL(0), DEFVAL(0));
+
+    // Golden-waveform comparison
+    ClassDB::bind_method(D_METHOD("compare_waveforms", "reference_time", "reference", "time", "values", "absolute", "relative", "t0", "t1"), &CircuitSimulator::compare_waveforms, DEFVAL(1e-3), DEFVAL(0.0), DEFVAL(0.0), DEFVAL(-1.0));
+    ClassDB::bind_method(D_METHOD("compare_to_golden", "golden", "absolute", "relative", "t0", "t1", "thread_count"), &CircuitSimulator::compare_to_golden, DEFVAL(1e-3), DEFVAL(0.0), DEFVAL(0.0), DEFVAL(-1.0), DEFVAL(0));
+
+    BIND_ENUM_CONSTANT(WINDOW_RECTANGULAR);
+    BIND_ENUM_CONSTANT(WINDOW_HANN);
+    BIND_ENUM_CONSTANT(WINDOW_HAMMING);
+    BIND_ENUM_CONSTANT(WINDOW_BLACKMAN);
+    BIND_ENUM_CONSTANT(WINDOW_FLAT_TOP);
 
     // Data retrieval
     ClassDB::bind_method(D_METHOD("get_voltage", "node_name"), &CircuitSimulator::get_voltage);
@@ -94,136 +184,116 @@ void CircuitSimulator::_bind_methods() {
     ClassDB::bind_method(D_METHOD("get_all_vectors"), &CircuitSimulator::get_all_vectors);
     ClassDB::bind_method(D_METHOD("get_all_vector_names"), &CircuitSimulator::get_all_vector_names);
 
+    // Compressed waveform store
+    ClassDB::bind_method(D_METHOD("set_waveform_compression", "enabled"), &CircuitSimulator::set_waveform_compression);
+    ClassDB::bind_method(D_METHOD("is_waveform_compression_enabled"), &CircuitSimulator::is_waveform_compression_enabled);
+    ClassDB::bind_method(D_METHOD("get_compressed_range", "vector_name", "t0", "t1"), &CircuitSimulator::get_compressed_range);
+    ClassDB::bind_method(D_METHOD("get_waveform_store_stats"), &CircuitSimulator::get_waveform_store_stats);
+    ClassDB::bind_method(D_METHOD("get_allocation_stats"), &CircuitSimulator::get_allocation_stats);
+
+    // Published snapshots of streamed data
+    ClassDB::bind_method(D_METHOD("set_snapshot_publishing", "enabled"), &CircuitSimulator::set_snapshot_publishing);
+    ClassDB::bind_method(D_METHOD("is_snapshot_publishing"), &CircuitSimulator::is_snapshot_publishing);
+    ClassDB::bind_method(D_METHOD("get_snapshot", "time"), &CircuitSimulator::get_snapshot, DEFVAL(-1.0));
+
+    // Convergence profiler
+    ClassDB::bind_method(D_METHOD("set_convergence_tracing", "enabled"), &CircuitSimulator::set_convergence_tracing);
+    ClassDB::bind_method(D_METHOD("is_convergence_tracing"), &CircuitSimulator::is_convergence_tracing);
+    ClassDB::bind_method(D_METHOD("get_convergence_trace"), &CircuitSimulator::get_convergence_trace);
+    ClassDB::bind_method(D_METHOD("get_stiff_intervals", "count", "bins"), &CircuitSimulator::get_stiff_intervals, DEFVAL(5), DEFVAL(100));
+    ClassDB::bind_method(D_METHOD("clear_convergence_trace"), &CircuitSimulator::clear_convergence_trace);
+
+    // Logic edge index
+    ClassDB::bind_method(D_METHOD("set_edge_threshold", "vector_name", "low", "high"), &CircuitSimulator::set_edge_threshold);
+    ClassDB::bind_method(D_METHOD("remove_edge_threshold", "vector_name"), &CircuitSimulator::remove_edge_threshold);
+    ClassDB::bind_method(D_METHOD("clear_edge_thresholds"), &CircuitSimulator::clear_edge_thresholds);
+    ClassDB::bind_method(D_METHOD("get_edges", "vector_name", "t0", "t1"), &CircuitSimulator::get_edges);
+    ClassDB::bind_method(D_METHOD("get_edge_count", "vector_name", "t0", "t1"), &CircuitSimulator::get_edge_count);
+    ClassDB::bind_method(D_METHOD("get_logic_state", "vector_name", "time"), &CircuitSimulator::get_logic_state);
+
     // Interactive control
     ClassDB::bind_method(D_METHOD("set_voltage_source", "source_name", "voltage"), &CircuitSimulator::set_voltage_source);
     ClassDB::bind_method(D_METHOD("get_voltage_source", "source_name"), &CircuitSimulator::get_voltage_source);
 
+    // Record / replay of source changes
+    ClassDB::bind_method(D_METHOD("start_source_recording"), &CircuitSimulator::start_source_recording);
+    ClassDB::bind_method(D_METHOD("stop_source_recording"), &CircuitSimulator::stop_source_recording);
+    ClassDB::bind_method(D_METHOD("start_source_replay", "log"), &CircuitSimulator::start_source_replay);
+    ClassDB::bind_method(D_METHOD("stop_source_replay"), &CircuitSimulator::stop_source_replay);
+    ClassDB::bind_method(D_METHOD("is_recording_sources"), &CircuitSimulator::is_recording_sources);
+    ClassDB::bind_method(D_METHOD("is_replaying_sources"), &CircuitSimulator::is_replaying_sources);
+    ClassDB::bind_method(D_METHOD("get_source_log"), &CircuitSimulator::get_source_log);
+    ClassDB::bind_method(D_METHOD("get_source_events"), &CircuitSimulator::get_source_events);
+
     // Signals
     ADD_SIGNAL(MethodInfo("simulation_started"));
     ADD_SIGNAL(MethodInfo("simulation_finished"));
+    ADD_SIGNAL(MethodInfo("simulation_failed", PropertyInfo(Variant::STRING, "error")));
     ADD_SIGNAL(MethodInfo("simulation_data_ready", PropertyInfo(Variant::DICTIONARY, "data")));
     ADD_SIGNAL(MethodInfo("ngspice_output", PropertyInfo(Variant::STRING, "message")));
+    ADD_SIGNAL(MethodInfo("ngspice_ready"));
+    ADD_SIGNAL(MethodInfo("queued_call_failed", PropertyInfo(Variant::STRING, "method")));
 }
 
 CircuitSimulator::CircuitSimulator() {
     initialized = false;
     current_netlist = "";
-    ngspice_handle = nullptr;
-    ng_Init = nullptr;
-    ng_Init_Sync = nullptr;
-    ng_Command = nullptr;
-    ng_GetVecInfo = nullptr;
-    ng_CurPlot = nullptr;
-    ng_AllPlots = nullptr;
-    ng_AllVecs = nullptr;
-    ng_Circ = nullptr;
-    ng_Running = nullptr;
-    instance = this;
+    initializing = false;
+    init_generation = 0;
+    init_succeeded = false;
+    init_buffering = false;
+    transient_step = 0.0;
+    transient_start = 0.0;
+    transient_stop = 0.0;
+    transient_horizon = 0.0;
+    stop_point_set = false;
+    stream_configured = false;
+    stream_generation = 0;
+    stream_scale = -1;
+    stream_time_scale = false;
+    data_ready_signal = StringName("simulation_data_ready");
+    waveform_compression = false;
+    convergence_tracing = false;
+    snapshot_publishing = false;
+    snapshot_configured = false;
+    debug_list_changed = false;
+    source_mode = SOURCE_LIVE;
+    worker_timeout = 0.0;
+    worker_job = -1;
 }
 
 CircuitSimulator::~CircuitSimulator() {
-    if (initialized) {
+    if (initialized || initializing) {
         shutdown_ngspice();
     }
-    if (instance == this) {
-        instance = nullptr;
-    }
 }
 
 bool CircuitSimulator::load_ngspice_library() {
-#ifdef _WIN32
-    ngspice_handle = LoadLibraryA("ngspice.dll");
-    if (!ngspice_handle) {
-        // Try loading from bin folder
-        ngspice_handle = LoadLibraryA("bin/ngspice.dll");
-    }
-    if (!ngspice_handle) {
-        UtilityFunctions::printerr("Failed to load ngspice.dll");
-        return false;
-    }
-
-    ng_Init = (int (*)(SendChar*, SendStat*, ControlledExit*, SendData*, SendInitData*, BGThreadRunning*, void*))
-        GetProcAddress(ngspice_handle, "ngSpice_Init");
-    ng_Init_Sync = (int (*)(GetVSRCData*, GetISRCData*, GetSyncData*, int*, void*))
-        GetProcAddress(ngspice_handle, "ngSpice_Init_Sync");
-    ng_Command = (int (*)(char*))
-        GetProcAddress(ngspice_handle, "ngSpice_Command");
-    ng_GetVecInfo = (pvector_info (*)(char*))
-        GetProcAddress(ngspice_handle, "ngGet_Vec_Info");
-    ng_CurPlot = (char* (*)())
-        GetProcAddress(ngspice_handle, "ngSpice_CurPlot");
-    ng_AllPlots = (char** (*)())
-        GetProcAddress(ngspice_handle, "ngSpice_AllPlots");
-    ng_AllVecs = (char** (*)(char*))
-        GetProcAddress(ngspice_handle, "ngSpice_AllVecs");
-    ng_Circ = (int (*)(char**))
-        GetProcAddress(ngspice_handle, "ngSpice_Circ");
-    ng_Running = (bool (*)())
-        GetProcAddress(ngspice_handle, "ngSpice_running");
-#else
-    ngspice_handle = dlopen("libngspice.so", RTLD_NOW);
-    if (!ngspice_handle) {
-        ngspice_handle = dlopen("./libngspice.so", RTLD_NOW);
-    }
-    if (!ngspice_handle) {
-        UtilityFunctions::printerr("Failed to load libngspice.so: " + String(dlerror()));
-        return false;
-    }
-
-    ng_Init = (int (*)(SendChar*, SendStat*, ControlledExit*, SendData*, SendInitData*, BGThreadRunning*, void*))
-        dlsym(ngspice_handle, "ngSpice_Init");
-    ng_Init_Sync = (int (*)(GetVSRCData*, GetISRCData*, GetSyncData*, int*, void*))
-        dlsym(ngspice_handle, "ngSpice_Init_Sync");
-    ng_Command = (int (*)(char*))
-        dlsym(ngspice_handle, "ngSpice_Command");
-    ng_GetVecInfo = (pvector_info (*)(char*))
-        dlsym(ngspice_handle, "ngGet_Vec_Info");
-    ng_CurPlot = (char* (*)())
-        dlsym(ngspice_handle, "ngSpice_CurPlot");
-    ng_AllPlots = (char** (*)())
-        dlsym(ngspice_handle, "ngSpice_AllPlots");
-    ng_AllVecs = (char** (*)(char*))
-        dlsym(ngspice_handle, "ngSpice_AllVecs");
-    ng_Circ = (int (*)(char**))
-        dlsym(ngspice_handle, "ngSpice_Circ");
-    ng_Running = (bool (*)())
-        dlsym(ngspice_handle, "ngSpice_running");
-#endif
-
-    if (!ng_Init || !ng_Command) {
-        UtilityFunctions::printerr("Failed to load required ngspice functions");
-        unload_ngspice_library();
+    // ngspice keeps its circuits and plots in globals, so every simulator
+    // loads its own copy of the library
+    std::string error;
+    if (!ngspice.load_copy(NgspiceLibrary::default_paths(), error)) {
+        report_error(String(error.c_str()));
         return false;
     }
-
     return true;
 }
 
 void CircuitSimulator::unload_ngspice_library() {
-#ifdef _WIN32
-    if (ngspice_handle) {
-        FreeLibrary(ngspice_handle);
-        ngspice_handle = nullptr;
-    }
-#else
-    if (ngspice_handle) {
-        dlclose(ngspice_handle);
-        ngspice_handle = nullptr;
-    }
-#endif
+    ngspice.unload();
 }
 
-bool CircuitSimulator::initialize_ngspice() {
-    if (initialized) {
-        UtilityFunctions::print("ngspice already initialized");
-        return true;
-    }
-
+bool CircuitSimulator::init_ngspice_instance(bool skip_spinit, const PackedStringArray &code_models) {
     if (!load_ngspice_library()) {
         return false;
     }
 
-    int ret = ng_Init(
+    // Must be called before ngSpice_Init to take effect
+    if (skip_spinit && ngspice.nospinit) {
+        ngspice.nospinit();
+    }
+
+    int ret = ngspice.init(
         ng_send_char,
         ng_send_stat,
         ng_controlled_exit,
@@ -234,28 +304,202 @@ bool CircuitSimulator::initialize_ngspice() {
     );
 
     if (ret != 0) {
-        UtilityFunctions::printerr("ngSpice_Init failed with code: " + String::num_int64(ret));
+        report_error("ngSpice_Init failed with code: " + String::num_int64(ret));
         unload_ngspice_library();
         return false;
     }
 
     // Set up voltage source callback for interactive control
-    if (ng_Init_Sync) {
-        ng_Init_Sync(ng_get_vsrc_data, nullptr, nullptr, nullptr, this);
+    register_sync_callbacks();
+
+    // Without spinit no code models are loaded, so load only the requested ones
+    for (int i = 0; i < code_models.size(); i++) {
+        CharString cmd = (String("codemodel ") + code_models[i]).utf8();
+        if (ngspice.command((char*)cmd.get_data()) != 0) {
+            report_error("Failed to load code model: " + code_models[i]);
+        }
+    }
+
+    return true;
+}
+
+bool CircuitSimulator::initialize_ngspice() {
+    if (initialized) {
+        UtilityFunctions::print("ngspice already initialized");
+        return true;
+    }
+
+    if (initializing) {
+        UtilityFunctions::printerr("ngspice initialization already in progress");
+        return false;
+    }
+
+    if (!init_ngspice_instance(false, PackedStringArray())) {
+        return false;
+    }
+
+    initialized = true;
+    UtilityFunctions::print("ngspice initialized successfully");
+    return true;
+}
+
+bool CircuitSimulator::initialize_ngspice_async(bool skip_spinit, const PackedStringArray &code_models) {
+    if (initialized) {
+        emit_signal("ngspice_ready");
+        return true;
+    }
+
+    if (initializing) {
+        return true;
+    }
+
+    if (init_thread.joinable()) {
+        init_thread.join();
+    }
+
+    // dlopen, symbol lookup, ngSpice_Init and code model loading all happen
+    // off the main thread; the result is handed back with a deferred call
+    initializing = true;
+    init_succeeded = false;
+    init_buffering = true;
+    uint64_t generation = ++init_generation;
+    init_thread = std::thread([this, skip_spinit, code_models, generation]() {
+        init_succeeded = init_ngspice_instance(skip_spinit, code_models);
+        call_deferred("_finish_async_init", init_succeeded, generation);
+    });
+    return true;
+}
+
+bool CircuitSimulator::defer_init_output(const char *text) {
+    // Nothing else calls into ngspice while it initializes, so all output
+    // seen while buffering comes from init_thread
+    std::lock_guard<std::mutex> lock(init_output_mutex);
+    if (!init_buffering) {
+        return false;
+    }
+    init_output.push_back({ text, false });
+    return true;
+}
+
+void CircuitSimulator::report_error(const String &message) {
+    {
+        std::lock_guard<std::mutex> lock(init_output_mutex);
+        if (init_buffering) {
+            init_output.push_back({ message.utf8().get_data(), true });
+            return;
+        }
+    }
+    UtilityFunctions::printerr(message);
+}
+
+void CircuitSimulator::flush_init_output() {
+    std::vector<InitOutput> output;
+    {
+        std::lock_guard<std::mutex> lock(init_output_mutex);
+        init_buffering = false;
+        output.swap(init_output);
+    }
+    for (const InitOutput &line : output) {
+        String text(line.text.c_str());
+        if (line.error) {
+            UtilityFunctions::printerr(text);
+        } else {
+            emit_signal("ngspice_output", text);
+            UtilityFunctions::print("[ngspice] ", text);
+        }
+    }
+}
+
+void CircuitSimulator::_finish_async_init(bool success, uint64_t generation) {
+    // Cancelled by shutdown_ngspice or superseded by a newer start
+    if (generation != init_generation || !initializing) {
+        return;
+    }
+
+    if (init_thread.joinable()) {
+        init_thread.join();
+    }
+    initializing = false;
+    flush_init_output();
+
+    Array calls = pending_calls;
+    PackedStringArray names = pending_names;
+    pending_calls = Array();
+    pending_names = PackedStringArray();
+
+    if (!success) {
+        UtilityFunctions::printerr("ngspice initialization failed, dropping " + String::num_int64(calls.size()) + " queued calls");
+        for (int i = 0; i < names.size(); i++) {
+            emit_signal("queued_call_failed", names[i]);
+        }
+        return;
     }
 
     initialized = true;
     UtilityFunctions::print("ngspice initialized successfully");
+
+    // Replay calls made while loading, in the order they were issued. They
+    // returned true when queued, so a failure is reported by signal.
+    for (int i = 0; i < calls.size(); i++) {
+        Callable call = calls[i];
+        Variant result = call.call();
+        if (result.get_type() == Variant::BOOL && !(bool)result) {
+            emit_signal("queued_call_failed", names[i]);
+        }
+    }
+
+    emit_signal("ngspice_ready");
+}
+
+bool CircuitSimulator::queue_until_ready(const Callable &call, const char *method) {
+    if (!initializing) {
+        return false;
+    }
+    pending_calls.append(call);
+    pending_names.append(String(method));
+    return true;
+}
+
+bool CircuitSimulator::is_still_initializing(const char *method) const {
+    if (!initializing) {
+        return false;
+    }
+    // Calls with a result cannot be queued
+    UtilityFunctions::printerr(String(method) + ": ngspice is still initializing; call it after ngspice_ready");
     return true;
 }
 
+bool CircuitSimulator::is_initializing() const {
+    return initializing;
+}
+
 void CircuitSimulator::shutdown_ngspice() {
+    if (init_thread.joinable()) {
+        init_thread.join();
+    }
+    if (initializing) {
+        // Cancel: the deferred _finish_async_init sees a newer generation
+        init_generation++;
+        initializing = false;
+        flush_init_output();
+        pending_calls = Array();
+        pending_names = PackedStringArray();
+        initialized = init_succeeded;
+    }
     if (!initialized) {
         return;
     }
 
-    if (ng_Command) {
-        ng_Command((char*)"quit");
+    // The library copy is unloaded below, so its background thread (which
+    // calls back into this object) has to be finished first
+    if (!halt_background()) {
+        // Unloading now would leave the thread running unmapped code
+        UtilityFunctions::printerr("ngspice background thread did not stop; library kept loaded");
+        return;
+    }
+
+    if (ngspice.command) {
+        ngspice.command((char*)"quit");
     }
 
     unload_ngspice_library();
@@ -268,229 +512,2138 @@ bool CircuitSimulator::is_initialized() const {
 }
 
 bool CircuitSimulator::load_netlist(const String &netlist_path) {
-    if (!initialized) {
-        UtilityFunctions::printerr("ngspice not initialized");
-        return false;
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::load_netlist).bind(netlist_path), "load_netlist")) {
+        return true;
     }
 
-    CharString path_utf8 = netlist_path.utf8();
-    std::string cmd = "source " + std::string(path_utf8.get_data());
-    int ret = ng_Command((char*)cmd.c_str());
+    // The worker backend sends the netlist with every run
+    if (!worker_pool.is_started()) {
+        if (!initialized) {
+            UtilityFunctions::printerr("ngspice not initialized");
+            return false;
+        }
+
+        CharString path_utf8 = netlist_path.utf8();
+        std::string cmd = "source " + std::string(path_utf8.get_data());
+        int ret = ngspice.command((char*)cmd.c_str());
 
-    if (ret != 0) {
-        UtilityFunctions::printerr("Failed to load netlist: " + netlist_path);
-        return false;
+        if (ret != 0) {
+            UtilityFunctions::printerr("Failed to load netlist: " + netlist_path);
+            return false;
+        }
     }
 
+    // ngspice reads the file itself; read it again for the topology and
+    // for warm starts. Relative includes are made absolute, since submitted
+    // lines resolve them against the working directory instead of the file.
+    op_node_names.clear();
+    op_node_voltages.clear();
+    alter_commands.clear();
+
+    String text = FileAccess::get_file_as_string(netlist_path);
+    split_netlist(text.utf8(), netlist_lines);
+    if (text.is_empty()) {
+        netlist_lines.clear();
+    }
+    resolve_include_paths(netlist_path.get_base_dir().utf8().get_data());
+    netlist_graph.parse(netlist_lines.data(), netlist_lines.size());
+
     current_netlist = netlist_path;
     UtilityFunctions::print("Loaded netlist: " + netlist_path);
     return true;
 }
 
 bool CircuitSimulator::load_netlist_string(const String &netlist_content) {
+    // The worker backend sends the netlist with every run
+    if (worker_pool.is_started()) {
+        split_netlist(netlist_content.utf8(), netlist_lines);
+        op_node_names.clear();
+        op_node_voltages.clear();
+        alter_commands.clear();
+        netlist_graph.parse(netlist_lines.data(), netlist_lines.size());
+        current_netlist = netlist_content;
+        return true;
+    }
+
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::load_netlist_string).bind(netlist_content), "load_netlist_string")) {
+        return true;
+    }
+
     if (!initialized) {
         UtilityFunctions::printerr("ngspice not initialized");
         return false;
     }
 
-    if (!ng_Circ) {
+    if (!ngspice.circ) {
         UtilityFunctions::printerr("ngSpice_Circ not available");
         return false;
     }
 
     // Split netlist into lines
-    PackedStringArray lines = netlist_content.split("\n");
-    std::vector<char*> circ_lines;
-    std::vector<std::string> line_storage;
-
-    for (int i = 0; i < lines.size(); i++) {
-        line_storage.push_back(std::string(lines[i].utf8().get_data()));
-        circ_lines.push_back((char*)line_storage.back().c_str());
-    }
-    circ_lines.push_back(nullptr);  // Null terminator
-
-    int ret = ng_Circ(circ_lines.data());
+    split_netlist(netlist_content.utf8(), netlist_lines);
 
-    if (ret != 0) {
+    if (!submit_netlist_lines("")) {
+        netlist_lines.clear();
         UtilityFunctions::printerr("Failed to load netlist from string");
         return false;
     }
 
+    // A new circuit invalidates the previous operating point and alters
+    op_node_names.clear();
+    op_node_voltages.clear();
+    alter_commands.clear();
+
+    netlist_graph.parse(netlist_lines.data(), netlist_lines.size());
+
     current_netlist = netlist_content;
     UtilityFunctions::print("Loaded netlist from string");
     return true;
 }
 
+void CircuitSimulator::split_netlist(const CharString &text, std::vector<char*> &lines) {
+    // One UTF-8 conversion for the whole text; lines are copied into the arena
+    netlist_arena.reset();
+    lines.clear();
+
+    const char *start = text.get_data();
+    while (true) {
+        const char *end = strchr(start, '\n');
+        size_t length = end ? (size_t)(end - start) : strlen(start);
+        lines.push_back(netlist_arena.copy_string(start, length));
+        if (!end) {
+            break;
+        }
+        start = end + 1;
+    }
+}
+
+void CircuitSimulator::resolve_include_paths(const std::string &base_dir) {
+    std::string resolved;
+    for (char *&line : netlist_lines) {
+        if (resolve_include_line(line, base_dir, resolved)) {
+            line = netlist_arena.copy_string(resolved.c_str(), resolved.size());
+        }
+    }
+}
+
+bool CircuitSimulator::submit_netlist_lines(const std::string &extra_card) {
+    // circ_lines keeps its capacity, so repeated warm starts don't allocate
+    circ_lines.clear();
+
+    // Extra cards go in front of the .end card, which must stay last
+    size_t end_index = netlist_lines.size();
+    if (!extra_card.empty()) {
+        for (size_t i = netlist_lines.size(); i > 0; i--) {
+            const char *line = netlist_lines[i - 1];
+            size_t first = strspn(line, " \t");
+            if ((strncmp(line + first, ".end", 4) == 0 || strncmp(line + first, ".END", 4) == 0) &&
+                (line[first + 4] == '\0' || isspace((unsigned char)line[first + 4]))) {
+                end_index = i - 1;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < netlist_lines.size(); i++) {
+        if (i == end_index) {
+            circ_lines.push_back((char*)extra_card.c_str());
+        }
+        circ_lines.push_back(netlist_lines[i]);
+    }
+    if (!extra_card.empty() && end_index == netlist_lines.size()) {
+        circ_lines.push_back((char*)extra_card.c_str());
+    }
+    circ_lines.push_back(nullptr);  // Null terminator
+
+    return ngspice.circ(circ_lines.data()) == 0;
+}
+
 String CircuitSimulator::get_current_netlist() const {
     return current_netlist;
 }
 
 bool CircuitSimulator::run_simulation() {
+    if (worker_pool.is_started()) {
+        return submit_worker_run("run");
+    }
+
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::run_simulation), "run_simulation")) {
+        return true;
+    }
+
     if (!initialized) {
         UtilityFunctions::printerr("ngspice not initialized");
         return false;
     }
 
-    int ret = ng_Command((char*)"bg_run");
+    apply_probes();
+    transient_horizon = 0.0;
+
+    int ret = ngspice.command((char*)"bg_run");
     return ret == 0;
 }
 
 bool CircuitSimulator::run_transient(double step, double stop, double start) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "tran %g %g %g", step, stop, start);
+    if (worker_pool.is_started()) {
+        return submit_worker_run(cmd);
+    }
+
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::run_transient).bind(step, stop, start), "run_transient")) {
+        return true;
+    }
+
     if (!initialized) {
         UtilityFunctions::printerr("ngspice not initialized");
         return false;
     }
 
-    char cmd[256];
-    snprintf(cmd, sizeof(cmd), "tran %g %g %g", step, stop, start);
-    int ret = ng_Command(cmd);
+    apply_probes();
+    transient_horizon = 0.0;
+
+    int ret = ngspice.command(cmd);
 
     return ret == 0;
 }
 
 bool CircuitSimulator::run_dc(const String &source, double start, double stop, double step) {
+    CharString source_utf8 = source.utf8();
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "dc %s %g %g %g", source_utf8.get_data(), start, stop, step);
+    if (worker_pool.is_started()) {
+        return submit_worker_run(cmd);
+    }
+
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::run_dc).bind(source, start, stop, step), "run_dc")) {
+        return true;
+    }
+
     if (!initialized) {
         UtilityFunctions::printerr("ngspice not initialized");
         return false;
     }
 
-    CharString source_utf8 = source.utf8();
-    char cmd[256];
-    snprintf(cmd, sizeof(cmd), "dc %s %g %g %g", source_utf8.get_data(), start, stop, step);
-    int ret = ng_Command(cmd);
+    apply_probes();
+    transient_horizon = 0.0;
+
+    int ret = ngspice.command(cmd);
 
     return ret == 0;
 }
 
 void CircuitSimulator::stop_simulation() {
+    if (worker_pool.is_started()) {
+        if (worker_job >= 0) {
+            UtilityFunctions::printerr("A worker run cannot be halted; it ends at the worker timeout");
+        }
+        return;
+    }
+
     if (!initialized) {
         return;
     }
 
-    ng_Command((char*)"bg_halt");
+    ngspice.command((char*)"bg_halt");
     UtilityFunctions::print("Simulation stopped");
 }
 
-bool CircuitSimulator::is_running() const {
-    if (!initialized || !ng_Running) {
-        return false;
+bool CircuitSimulator::halt_background() {
+    if (!ngspice.running || !ngspice.running()) {
+        return true;
+    }
+
+    // bg_halt only requests the halt; the thread stops at its next check
+    ngspice.command((char*)"bg_halt");
+    for (int i = 0; i < 5000 && ngspice.running(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
-    return ng_Running();
+    return !ngspice.running();
 }
 
-Array CircuitSimulator::get_voltage(const String &node_name) {
-    Array result;
+bool CircuitSimulator::set_transient_breakpoint(double stop) {
+    // Replaces the previous stop point. The condition is checked after each
+    // accepted timepoint, so the run halts on the first one past 'stop'.
+    // The old one can only go with the whole list; saves are read when an
+    // analysis starts, so the halted run keeps its vectors and the next run
+    // issues them again.
+    if (stop_point_set) {
+        clear_debug_list();
+    }
 
-    if (!initialized || !ng_GetVecInfo) {
-        return result;
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "stop when time > %.17g", stop);
+    debug_list_changed = true;
+    if (ngspice.command(cmd) != 0) {
+        UtilityFunctions::printerr("Failed to set transient breakpoint");
+        return false;
     }
 
-    CharString name_utf8 = (String("v(") + node_name + ")").utf8();
-    pvector_info vec = ng_GetVecInfo((char*)name_utf8.get_data());
+    stop_point_set = true;
+    transient_stop = stop;
+    return true;
+}
 
-    if (vec && vec->v_realdata) {
-        for (int i = 0; i < vec->v_length; i++) {
-            result.append(vec->v_realdata[i]);
-        }
+bool CircuitSimulator::run_transient_resumable(double step, double stop, double horizon, double start) {
+    if (needs_local_library("run_transient_resumable")) {
+        return false;
     }
 
-    return result;
-}
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::run_transient_resumable).bind(step, stop, horizon, start), "run_transient_resumable")) {
+        return true;
+    }
 
-Array CircuitSimulator::get_current(const String &source_name) {
-    Array result;
+    if (!initialized) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return false;
+    }
 
-    if (!initialized || !ng_GetVecInfo) {
-        return result;
+    if (horizon < stop) {
+        horizon = stop;
     }
 
-    CharString name_utf8 = (String("i(") + source_name + ")").utf8();
-    pvector_info vec = ng_GetVecInfo((char*)name_utf8.get_data());
+    // ngspice fixes the end time when the analysis starts, so the run is set
+    // up to the horizon and halted at 'stop'. Extending then resumes from the
+    // last accepted timepoint instead of re-simulating from t=0.
+    apply_probes();
+    if (!set_transient_breakpoint(stop)) {
+        return false;
+    }
 
-    if (vec && vec->v_realdata) {
-        for (int i = 0; i < vec->v_length; i++) {
-            result.append(vec->v_realdata[i]);
-        }
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "bg_tran %g %g %g", step, horizon, start);
+    if (ngspice.command(cmd) != 0) {
+        return false;
     }
 
-    return result;
+    transient_step = step;
+    transient_start = start;
+    transient_horizon = horizon;
+    return true;
 }
 
-Array CircuitSimulator::get_time_vector() {
-    Array result;
-
-    if (!initialized || !ng_GetVecInfo) {
-        return result;
+bool CircuitSimulator::extend_transient(double new_stop) {
+    if (needs_local_library("extend_transient")) {
+        return false;
     }
 
-    pvector_info vec = ng_GetVecInfo((char*)"time");
-
-    if (vec && vec->v_realdata) {
-        for (int i = 0; i < vec->v_length; i++) {
-            result.append(vec->v_realdata[i]);
-        }
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::extend_transient).bind(new_stop), "extend_transient")) {
+        return true;
     }
 
-    return result;
-}
+    if (!initialized) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return false;
+    }
 
-Dictionary CircuitSimulator::get_all_vectors() {
-    Dictionary result;
+    if (transient_horizon <= 0.0) {
+        UtilityFunctions::printerr("No resumable transient run; use run_transient_resumable first");
+        return false;
+    }
 
-    if (!initialized || !ng_CurPlot || !ng_AllVecs || !ng_GetVecInfo) {
-        return result;
+    if (new_stop <= transient_stop) {
+        return true;
     }
 
-    char* cur_plot = ng_CurPlot();
-    if (!cur_plot) {
-        return result;
+    // The breakpoint and bg_resume must not race the background thread
+    if (!halt_background()) {
+        UtilityFunctions::printerr("ngspice background thread did not stop; cannot extend");
+        return false;
     }
 
-    char** all_vecs = ng_AllVecs(cur_plot);
-    if (!all_vecs) {
-        return result;
+    // The end time cannot be moved once the analysis runs, so past the
+    // horizon it starts over from t=0. Doubling the horizon keeps repeated
+    // extends from re-simulating every time.
+    if (new_stop > transient_horizon) {
+        return run_transient_resumable(transient_step, new_stop, std::max(new_stop, 2.0 * transient_horizon),
+            transient_start);
     }
 
-    for (int i = 0; all_vecs[i] != nullptr; i++) {
-        pvector_info vec = ng_GetVecInfo(all_vecs[i]);
-        if (vec && vec->v_realdata) {
-            Array data;
-            for (int j = 0; j < vec->v_length; j++) {
-                data.append(vec->v_realdata[j]);
-            }
-            result[String(all_vecs[i])] = data;
-        }
+    if (!set_transient_breakpoint(new_stop)) {
+        return false;
     }
 
-    return result;
+    // New samples are appended to the vectors of the existing plot
+    return ngspice.command((char*)"bg_resume") == 0;
 }
 
-PackedStringArray CircuitSimulator::get_all_vector_names() {
+void CircuitSimulator::pause_simulation() {
+    if (needs_local_library("pause_simulation")) {
+        return;
+    }
+
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::pause_simulation), "pause_simulation")) {
+        return;
+    }
+
+    if (!initialized) {
+        return;
+    }
+
+    ngspice.command((char*)"bg_halt");
+}
+
+bool CircuitSimulator::resume_simulation() {
+    if (needs_local_library("resume_simulation")) {
+        return false;
+    }
+
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::resume_simulation), "resume_simulation")) {
+        return true;
+    }
+
+    if (!initialized) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return false;
+    }
+
+    if (is_running()) {
+        return true;
+    }
+
+    return ngspice.command((char*)"bg_resume") == 0;
+}
+
+double CircuitSimulator::get_transient_stop() const {
+    return transient_stop;
+}
+
+double CircuitSimulator::get_transient_horizon() const {
+    return transient_horizon;
+}
+
+bool CircuitSimulator::is_running() const {
+    if (worker_pool.is_started()) {
+        return worker_job >= 0;
+    }
+    if (!initialized || !ngspice.running) {
+        return false;
+    }
+    return ngspice.running();
+}
+
+bool CircuitSimulator::set_worker_backend(bool enabled, const String &executable_path, const String &library_path,
+        double timeout) {
+    worker_pool.stop();
+    worker_job = -1;
+    worker_result = SimAnalysis();
+    set_process(false);
+    if (!enabled) {
+        return true;
+    }
+
+    String executable = SimWorkerPool::resolve_executable_path(executable_path);
+    String library = library_path.is_empty() ? library_path : ProjectSettings::get_singleton()->globalize_path(library_path);
+
+    std::string error;
+    if (!worker_pool.start(executable.utf8().get_data(), library.utf8().get_data(), 1, 1 << 20, error)) {
+        UtilityFunctions::printerr("Failed to start simulation worker: " + String(error.c_str()));
+        return false;
+    }
+    worker_timeout = timeout;
+    set_process(true);
+    return true;
+}
+
+bool CircuitSimulator::is_worker_backend() const {
+    return worker_pool.is_started();
+}
+
+bool CircuitSimulator::needs_local_library(const char *method) const {
+    if (!worker_pool.is_started()) {
+        return false;
+    }
+    // Would otherwise act on the idle in-process library
+    UtilityFunctions::printerr(String(method) + " needs the in-process library; disable the worker backend first");
+    return true;
+}
+
+bool CircuitSimulator::submit_worker_run(const std::string &analysis) {
+    if (netlist_lines.empty()) {
+        UtilityFunctions::printerr("No netlist loaded");
+        return false;
+    }
+    if (worker_job >= 0) {
+        UtilityFunctions::printerr("A worker run is already in progress");
+        return false;
+    }
+
+    std::vector<std::string> netlist(netlist_lines.begin(), netlist_lines.end());
+    std::vector<std::string> commands;
+    if (probes.size() > 0) {
+        std::string save = "save";
+        for (int i = 0; i < probes.size(); i++) {
+            save += " ";
+            save += probes[i].utf8().get_data();
+        }
+        commands.push_back(save);
+    }
+    commands.push_back(analysis);
+
+    worker_job = worker_pool.submit(netlist, commands, worker_timeout);
+    emit_signal("simulation_started");
+    return true;
+}
+
+void CircuitSimulator::poll_worker() {
+    std::vector<int> finished;
+    std::vector<int> restarted;
+    worker_pool.poll(finished, restarted);
+
+    for (int job_id : finished) {
+        SimJob *job = worker_pool.get_job(job_id);
+        if (!job || job_id != worker_job) {
+            worker_pool.release_job(job_id);
+            continue;
+        }
+        worker_job = -1;
+
+        for (const std::string &line : job->output) {
+            emit_signal("ngspice_output", String(line.c_str()));
+        }
+        bool success = job->state == SimJob::DONE;
+        String error = String(job->error.c_str());
+        if (success) {
+            worker_result = job->analyses.empty() ? SimAnalysis() : std::move(job->analyses.back());
+        }
+        worker_pool.release_job(job_id);
+
+        if (success) {
+            emit_signal("simulation_finished");
+        } else {
+            UtilityFunctions::printerr("Worker run failed: " + error);
+            emit_signal("simulation_failed", error);
+        }
+    }
+}
+
+Array CircuitSimulator::get_worker_vector(const String &vector_name) const {
+    Array result;
+    std::string key = probe_key(vector_name.utf8().get_data());
+    for (size_t i = 0; i < worker_result.vector_names.size(); i++) {
+        if (probe_key(worker_result.vector_names[i].c_str()) == key) {
+            std::vector<double> values(worker_result.get_row_count());
+            worker_result.copy_vector(i, values.data());
+            for (double value : values) {
+                result.append(value);
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+void CircuitSimulator::_notification(int p_what) {
+    if (p_what == NOTIFICATION_PROCESS && worker_pool.is_started()) {
+        poll_worker();
+    }
+}
+
+Dictionary CircuitSimulator::run_operating_point(bool warm_start) {
+    if (needs_local_library("run_operating_point")) {
+        return Dictionary();
+    }
+
+    Dictionary result;
+
+    if (is_still_initializing("run_operating_point")) {
+        return result;
+    }
+
+    if (!initialized || !ngspice.cur_plot || !ngspice.all_vecs || !ngspice.get_vec_info) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return result;
+    }
+
+    if (is_running()) {
+        UtilityFunctions::printerr("Cannot run operating point while a simulation is running");
+        return result;
+    }
+
+    // "op" runs in the foreground on the loaded circuit, so a toggle costs
+    // no re-parse and results are available on return
+    char* previous = ngspice.cur_plot();
+    std::string previous_plot = previous ? previous : "";
+    bool converged = ngspice.command((char*)"op") == 0;
+
+    // Warm start, only for an op that fails on its own: ngspice reads
+    // .nodeset only while parsing, so seeding the previous solution means
+    // replacing the circuit with one that carries it as .nodeset. That
+    // re-parse is kept off the common path.
+    if (!converged && warm_start && !netlist_lines.empty() && op_node_names.size() > 0) {
+        char* failed_plot = ngspice.cur_plot();
+        if (failed_plot && previous_plot != failed_plot) {
+            std::string destroy_cmd = std::string("destroy ") + failed_plot;
+            ngspice.command((char*)destroy_cmd.c_str());
+        }
+
+        std::string nodeset = ".nodeset";
+        char value[64];
+        for (int i = 0; i < op_node_names.size(); i++) {
+            snprintf(value, sizeof(value), ")=%.17g", op_node_voltages[i]);
+            nodeset += " v(";
+            nodeset += op_node_names[i].utf8().get_data();
+            nodeset += value;
+        }
+        // The old circuit goes first, so retries don't pile up circuits
+        ngspice.command((char*)"remcirc");
+        if (!submit_netlist_lines(nodeset)) {
+            UtilityFunctions::printerr("Failed to apply nodeset for warm start");
+            submit_netlist_lines("");
+            reapply_alters();
+            return result;
+        }
+        reapply_alters();
+        converged = ngspice.command((char*)"op") == 0;
+    }
+
+    if (!converged) {
+        UtilityFunctions::printerr("Operating point analysis failed");
+        return result;
+    }
+
+    // Drop the previous op plot so repeated toggles don't accumulate plots
+    char* cur_plot = ngspice.cur_plot();
+    if (!cur_plot) {
+        return result;
+    }
+    String plot_name = String(cur_plot);
+    if (!op_plot.is_empty() && op_plot != plot_name) {
+        CharString destroy_cmd = (String("destroy ") + op_plot).utf8();
+        ngspice.command((char*)destroy_cmd.get_data());
+    }
+    op_plot = plot_name;
+
+    char** all_vecs = ngspice.all_vecs(cur_plot);
+    if (!all_vecs) {
+        return result;
+    }
+
+    PackedStringArray nodes;
+    PackedFloat64Array voltages;
+    PackedStringArray branches;
+    PackedFloat64Array currents;
+
+    for (int i = 0; all_vecs[i] != nullptr; i++) {
+        pvector_info vec = ngspice.get_vec_info(all_vecs[i]);
+        if (!vec || !vec->v_realdata || vec->v_length < 1) {
+            continue;
+        }
+
+        // Branch currents are named "<device>#branch"; other '#' vectors are
+        // internal device nodes, which are not useful to the visualizer
+        const char* hash = strchr(all_vecs[i], '#');
+        if (!hash) {
+            nodes.append(String(all_vecs[i]));
+            voltages.append(vec->v_realdata[0]);
+        } else if (strcmp(hash, "#branch") == 0) {
+            branches.append(String(all_vecs[i], (int)(hash - all_vecs[i])));
+            currents.append(vec->v_realdata[0]);
+        }
+    }
+
+    op_node_names = nodes;
+    op_node_voltages = voltages;
+
+    result["nodes"] = nodes;
+    result["voltages"] = voltages;
+    result["branches"] = branches;
+    result["currents"] = currents;
+    return result;
+}
+
+bool CircuitSimulator::alter_component(const String &device, double value, const String &parameter) {
+    if (needs_local_library("alter_component")) {
+        return false;
+    }
+
+    if (queue_until_ready(callable_mp(this, &CircuitSimulator::alter_component).bind(device, value, parameter), "alter_component")) {
+        return true;
+    }
+
+    if (!initialized) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return false;
+    }
+
+    std::string target = device.utf8().get_data();
+    if (!parameter.is_empty()) {
+        target += " ";
+        target += parameter.utf8().get_data();
+    }
+    char number[64];
+    snprintf(number, sizeof(number), " = %.17g", value);
+    std::string cmd = "alter " + target + number;
+    if (ngspice.command((char*)cmd.c_str()) != 0) {
+        UtilityFunctions::printerr("Failed to alter " + device);
+        return false;
+    }
+
+    for (AlterCommand &alter : alter_commands) {
+        if (alter.target == target) {
+            alter.command = cmd;
+            return true;
+        }
+    }
+    alter_commands.push_back({ target, cmd });
+    return true;
+}
+
+void CircuitSimulator::reapply_alters() {
+    for (const AlterCommand &alter : alter_commands) {
+        ngspice.command((char*)alter.command.c_str());
+    }
+}
+
+// Points of one dc source sweep, stepped the way ngspice steps it: the
+// value is accumulated and the sweep ends once it passes 'stop' by more
+// than a small absolute tolerance
+static int64_t dc_point_count(double start, double stop, double step) {
+    int64_t count = 0;
+    double point = start;
+    double sign = step > 0.0 ? 1.0 : -1.0;
+    while (sign * (point - stop) <= DBL_EPSILON * 1e3) {
+        count++;
+        point += step;
+    }
+    return count;
+}
+
+Ref<SweepTensor> CircuitSimulator::run_sweep(const Array &axes, const PackedStringArray &outputs) {
+    if (needs_local_library("run_sweep")) {
+        return Ref<SweepTensor>();
+    }
+
+    if (is_still_initializing("run_sweep")) {
+        return Ref<SweepTensor>();
+    }
+
+    if (!initialized || !ngspice.cur_plot || !ngspice.get_vec_info) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return Ref<SweepTensor>();
+    }
+
+    if (is_running()) {
+        UtilityFunctions::printerr("Cannot run a sweep while a simulation is running");
+        return Ref<SweepTensor>();
+    }
+
+    if (outputs.size() == 0) {
+        UtilityFunctions::printerr("Sweep needs at least one output vector");
+        return Ref<SweepTensor>();
+    }
+
+    // Axes are given outermost first. Parameter axes ("param" via alterparam,
+    // "device" via alter) are looped here; source axes are handed to a single
+    // "dc" command, which sweeps its first source fastest.
+    struct SweepAxis {
+        std::string command;
+        bool is_param;
+        bool is_source;
+        double start, stop, step;
+        PackedFloat64Array values;
+    };
+    std::vector<SweepAxis> sweep_axes;
+    int source_count = 0;
+    bool needs_reset = false;
+
+    for (int i = 0; i < axes.size(); i++) {
+        Dictionary spec = axes[i];
+        SweepAxis axis;
+        axis.is_param = false;
+        axis.is_source = false;
+        axis.start = axis.stop = axis.step = 0.0;
+
+        if (spec.has("source")) {
+            axis.is_source = true;
+            axis.command = String(spec["source"]).utf8().get_data();
+            axis.start = spec.get("start", 0.0);
+            axis.stop = spec.get("stop", 0.0);
+            axis.step = spec.get("step", 0.0);
+            if (axis.step == 0.0 || (axis.stop - axis.start) / axis.step < 0.0) {
+                UtilityFunctions::printerr("Invalid range for sweep source: ", String(spec["source"]));
+                return Ref<SweepTensor>();
+            }
+            // Point counts come from the first dc result, not from the range
+            source_count++;
+        } else if (spec.has("param") || spec.has("device")) {
+            if (source_count > 0) {
+                UtilityFunctions::printerr("Sweep parameter axes must come before source axes");
+                return Ref<SweepTensor>();
+            }
+            axis.is_param = spec.has("param");
+            axis.command = String(axis.is_param ? spec["param"] : spec["device"]).utf8().get_data();
+            axis.values = spec.get("values", PackedFloat64Array());
+            if (axis.values.size() == 0) {
+                UtilityFunctions::printerr("Sweep axis has no values: ", String(axis.command.c_str()));
+                return Ref<SweepTensor>();
+            }
+            needs_reset = needs_reset || axis.is_param;
+        } else {
+            UtilityFunctions::printerr("Sweep axis needs a \"source\", \"param\" or \"device\" key");
+            return Ref<SweepTensor>();
+        }
+        sweep_axes.push_back(axis);
+    }
+
+    if (source_count > 2) {
+        UtilityFunctions::printerr("A sweep can have at most two source axes");
+        return Ref<SweepTensor>();
+    }
+
+    // Shape is [output, axes...]; each run fills one contiguous block per
+    // output. The block size is only known once the first run returns.
+    int loop_count = (int)sweep_axes.size() - source_count;
+    int64_t block = 0;
+    int64_t runs = 1;
+    for (int i = 0; i < loop_count; i++) {
+        runs *= sweep_axes[i].values.size();
+    }
+
+    PackedFloat64Array buffer;
+    double *dst = nullptr;
+
+    // Only keep the requested outputs; the next regular run restores the probe set
+    std::string save_cmd = "save";
+    std::vector<std::string> output_keys;
+    for (int i = 0; i < outputs.size(); i++) {
+        std::string name = outputs[i].utf8().get_data();
+        output_keys.push_back(probe_key(name.c_str()));
+        save_cmd += " " + name;
+    }
+    clear_debug_list();
+    ngspice.command((char*)save_cmd.c_str());
+    transient_horizon = 0.0;
+
+    std::string analysis = "op";
+    char value[64];
+    if (source_count > 0) {
+        analysis = "dc";
+        for (int i = (int)sweep_axes.size() - 1; i >= loop_count; i--) {
+            const SweepAxis &axis = sweep_axes[i];
+            snprintf(value, sizeof(value), " %.17g %.17g %.17g", axis.start, axis.stop, axis.step);
+            analysis += " " + axis.command + value;
+        }
+    }
+
+    // The first run fixes the source axes: a single source takes the
+    // length of the returned vector. With two, the inner (first) source
+    // steps like ngspice does and the outer one gets the rest.
+    auto size_source_axes = [&](int64_t length) {
+        if (source_count == 0) {
+            return length == 1;
+        }
+        SweepAxis &inner = sweep_axes.back();
+        int64_t inner_count = source_count == 1 ? length : dc_point_count(inner.start, inner.stop, inner.step);
+        if (inner_count <= 0 || length % inner_count != 0) {
+            return false;
+        }
+        for (int i = loop_count; i < (int)sweep_axes.size(); i++) {
+            SweepAxis &axis = sweep_axes[i];
+            int64_t count = &axis == &inner ? inner_count : length / inner_count;
+            axis.values.resize(count);
+            double point = axis.start;
+            for (int64_t n = 0; n < count; n++) {
+                axis.values.set(n, point);
+                point += axis.step;
+            }
+        }
+        return true;
+    };
+
+    // Parameter values are put back by re-submitting the netlist
+    auto restore_circuit = [&]() {
+        if (loop_count == 0) {
+            return;
+        }
+        if (netlist_lines.empty()) {
+            UtilityFunctions::printerr("Sweep cannot restore the altered values; reload the netlist");
+            return;
+        }
+        ngspice.command((char*)"remcirc");
+        submit_netlist_lines("");
+        reapply_alters();
+    };
+    // A failed run can leave a partial plot behind
+    auto destroy_new_plot = [&](const std::string &previous_plot) {
+        char* plot = ngspice.cur_plot();
+        if (plot && previous_plot != plot) {
+            std::string destroy_cmd = std::string("destroy ") + plot;
+            ngspice.command((char*)destroy_cmd.c_str());
+        }
+    };
+
+    std::vector<int64_t> index(loop_count, 0);
+    for (int64_t run = 0; run < runs; run++) {
+        // Apply this combination of parameter values
+        for (int i = 0; i < loop_count; i++) {
+            const SweepAxis &axis = sweep_axes[i];
+            snprintf(value, sizeof(value), " = %.17g", axis.values[index[i]]);
+            std::string cmd = (axis.is_param ? "alterparam " : "alter ") + axis.command + value;
+            ngspice.command((char*)cmd.c_str());
+        }
+        if (needs_reset) {
+            ngspice.command((char*)"reset");
+        }
+
+        char* previous = ngspice.cur_plot();
+        std::string previous_plot = previous ? previous : "";
+        if (ngspice.command((char*)analysis.c_str()) != 0) {
+            UtilityFunctions::printerr("Sweep analysis failed: ", String(analysis.c_str()));
+            destroy_new_plot(previous_plot);
+            restore_circuit();
+            return Ref<SweepTensor>();
+        }
+
+        char* cur_plot = ngspice.cur_plot();
+        if (!cur_plot) {
+            restore_circuit();
+            return Ref<SweepTensor>();
+        }
+        std::string plot_name = cur_plot;
+
+        for (int o = 0; o < outputs.size(); o++) {
+            pvector_info vec = ngspice.get_vec_info((char*)output_keys[o].c_str());
+            if (block == 0 && vec && vec->v_realdata && size_source_axes(vec->v_length)) {
+                block = vec->v_length;
+                buffer.resize(outputs.size() * runs * block);
+                dst = buffer.ptrw();
+            }
+            if (!vec || !vec->v_realdata || vec->v_length != block) {
+                UtilityFunctions::printerr("Sweep output missing or wrong length: ", outputs[o]);
+                destroy_new_plot(previous_plot);
+                restore_circuit();
+                return Ref<SweepTensor>();
+            }
+            memcpy(dst + (o * runs + run) * block, vec->v_realdata, sizeof(double) * block);
+        }
+
+        // Each analysis creates a plot; drop it once copied
+        std::string destroy_cmd = "destroy " + plot_name;
+        ngspice.command((char*)destroy_cmd.c_str());
+
+        for (int i = loop_count - 1; i >= 0; i--) {
+            if (++index[i] < sweep_axes[i].values.size()) {
+                break;
+            }
+            index[i] = 0;
+        }
+    }
+    restore_circuit();
+
+    std::vector<int64_t> shape;
+    shape.push_back(outputs.size());
+    for (size_t i = 0; i < sweep_axes.size(); i++) {
+        shape.push_back(sweep_axes[i].values.size());
+    }
+
+    PackedStringArray names;
+    Array values;
+    Array labels;
+    names.append("output");
+    values.append(PackedFloat64Array());
+    labels.append(outputs);
+    for (size_t i = 0; i < sweep_axes.size(); i++) {
+        names.append(String(sweep_axes[i].command.c_str()));
+        values.append(sweep_axes[i].values);
+        labels.append(PackedStringArray());
+    }
+
+    Ref<SweepTensor> tensor;
+    tensor.instantiate();
+    tensor->setup(buffer, shape, names, values, labels);
+    return tensor;
+}
+
+Dictionary CircuitSimulator::get_netlist_graph() const {
+    PackedStringArray node_names;
+    for (const std::string &name : netlist_graph.get_node_names()) {
+        node_names.append(String(name.c_str()));
+    }
+    PackedStringArray element_names;
+    PackedStringArray element_types;
+    for (size_t e = 0; e < netlist_graph.get_element_count(); e++) {
+        element_names.append(String(netlist_graph.get_element_names()[e].c_str()));
+        char type[2] = { netlist_graph.get_element_types()[e], 0 };
+        element_types.append(String(type));
+    }
+
+    auto to_packed = [](const std::vector<int32_t> &values) {
+        PackedInt32Array result;
+        result.resize(values.size());
+        if (!values.empty()) {
+            memcpy(result.ptrw(), values.data(), sizeof(int32_t) * values.size());
+        }
+        return result;
+    };
+
+    Dictionary result;
+    result["node_names"] = node_names;
+    result["element_names"] = element_names;
+    result["element_types"] = element_types;
+    result["element_offsets"] = to_packed(netlist_graph.get_element_offsets());
+    result["element_pins"] = to_packed(netlist_graph.get_element_pins());
+    result["node_offsets"] = to_packed(netlist_graph.get_node_offsets());
+    result["node_elements"] = to_packed(netlist_graph.get_node_elements());
+    result["ground"] = netlist_graph.get_ground();
+    return result;
+}
+
+Dictionary CircuitSimulator::layout_netlist_graph(int iterations, double spacing, int thread_count, bool include_ground) {
+    Dictionary result;
+    if (netlist_graph.get_element_count() == 0) {
+        UtilityFunctions::printerr("No netlist topology loaded");
+        return result;
+    }
+
+    // Bipartite layout graph: nodes first, then elements. Ground is usually
+    // drawn as a local symbol per element, so its edges are left out by default.
+    const size_t node_count = netlist_graph.get_node_count();
+    const size_t element_count = netlist_graph.get_element_count();
+    const int32_t ground = include_ground ? -1 : netlist_graph.get_ground();
+    const std::vector<int32_t> &node_offsets = netlist_graph.get_node_offsets();
+    const std::vector<int32_t> &node_elements = netlist_graph.get_node_elements();
+    const std::vector<int32_t> &element_offsets = netlist_graph.get_element_offsets();
+    const std::vector<int32_t> &element_pins = netlist_graph.get_element_pins();
+
+    std::vector<int32_t> offsets;
+    std::vector<int32_t> targets;
+    offsets.reserve(node_count + element_count + 1);
+    targets.reserve(element_pins.size() * 2);
+    offsets.push_back(0);
+    for (size_t n = 0; n < node_count; n++) {
+        if ((int32_t)n != ground) {
+            for (int32_t i = node_offsets[n]; i < node_offsets[n + 1]; i++) {
+                targets.push_back((int32_t)node_count + node_elements[i]);
+            }
+        }
+        offsets.push_back((int32_t)targets.size());
+    }
+    for (size_t e = 0; e < element_count; e++) {
+        for (int32_t p = element_offsets[e]; p < element_offsets[e + 1]; p++) {
+            if (element_pins[p] != ground) {
+                targets.push_back(element_pins[p]);
+            }
+        }
+        offsets.push_back((int32_t)targets.size());
+    }
+
+    GraphLayout::Settings settings;
+    settings.iterations = iterations;
+    settings.spacing = (float)spacing;
+    settings.threads = thread_count;
+
+    std::vector<float> xs;
+    std::vector<float> ys;
+    auto start = std::chrono::steady_clock::now();
+    GraphLayout::run(node_count + element_count, offsets, targets, settings, xs, ys);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    PackedVector2Array node_positions;
+    node_positions.resize(node_count);
+    for (size_t n = 0; n < node_count; n++) {
+        node_positions.set(n, Vector2(xs[n], ys[n]));
+    }
+    PackedVector2Array element_positions;
+    element_positions.resize(element_count);
+    for (size_t e = 0; e < element_count; e++) {
+        element_positions.set(e, Vector2(xs[node_count + e], ys[node_count + e]));
+    }
+
+    result["node_positions"] = node_positions;
+    result["element_positions"] = element_positions;
+    result["time_ms"] = elapsed.count();
+    return result;
+}
+
+bool CircuitSimulator::load_uniform_samples(const String &vector_name, int64_t &points, double &t0, double &t1,
+        std::vector<double> &samples) {
+    if (!initialized || !ngspice.get_vec_info) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return false;
+    }
+
+    // Vector data may be reallocated while ngspice appends to it
+    if (is_running()) {
+        UtilityFunctions::printerr("Cannot compute a spectrum while a simulation is running");
+        return false;
+    }
+
+    const double *t;
+    size_t count;
+    const double *values;
+    size_t value_count;
+    CharString name_utf8 = vector_name.utf8();
+    if (!ngspice.find_real_vector("time", t, count) || !ngspice.find_real_vector(name_utf8.get_data(), values, value_count)) {
+        UtilityFunctions::printerr("Spectrum needs a transient vector: " + vector_name);
+        return false;
+    }
+    if (value_count != count || count < 2) {
+        UtilityFunctions::printerr("Vector does not match the time scale: " + vector_name);
+        return false;
+    }
+
+    t0 = std::max(t0, t[0]);
+    t1 = (t1 < 0.0 || t1 > t[count - 1]) ? t[count - 1] : t1;
+    if (!(t1 > t0)) {
+        UtilityFunctions::printerr("Empty time range for spectrum");
+        return false;
+    }
+
+    // Default: about as many samples as the run has in the range
+    if (points <= 0) {
+        const double *first = std::lower_bound(t, t + count, t0);
+        const double *last = std::upper_bound(t, t + count, t1);
+        points = (int64_t)(last - first);
+    }
+    points = (int64_t)SpectrumAnalyzer::next_power_of_two((size_t)std::max<int64_t>(points, 2));
+
+    samples.resize(points);
+    return SpectrumAnalyzer::resample(t, values, count, t0, t1, (size_t)points, samples.data());
+}
+
+static PackedFloat64Array bin_frequencies(int64_t points, double t0, double t1) {
+    double resolution = 1.0 / (t1 - t0);
+    PackedFloat64Array frequency;
+    frequency.resize(points / 2 + 1);
+    double *dst = frequency.ptrw();
+    for (int64_t k = 0; k <= points / 2; k++) {
+        dst[k] = resolution * (double)k;
+    }
+    return frequency;
+}
+
+Dictionary CircuitSimulator::get_spectrum(const String &vector_name, int points, SpectrumWindow window,
+        double t0, double t1) {
+    if (needs_local_library("get_spectrum")) {
+        return Dictionary();
+    }
+
+    Dictionary result;
+    int64_t size = points;
+    std::vector<double> samples;
+    if (!load_uniform_samples(vector_name, size, t0, t1, samples)) {
+        return result;
+    }
+
+    PackedFloat64Array magnitude;
+    PackedFloat64Array phase;
+    magnitude.resize(size / 2 + 1);
+    phase.resize(size / 2 + 1);
+    SpectrumAnalyzer::analyze(samples.data(), (size_t)size, (SpectrumAnalyzer::Window)window,
+        magnitude.ptrw(), phase.ptrw());
+
+    result["frequency"] = bin_frequencies(size, t0, t1);
+    result["magnitude"] = magnitude;
+    result["phase"] = phase;
+    result["sample_rate"] = (double)size / (t1 - t0);
+    return result;
+}
+
+Dictionary CircuitSimulator::get_spectra(const PackedStringArray &vector_names, int points, SpectrumWindow window,
+        double t0, double t1, int thread_count) {
+    if (needs_local_library("get_spectra")) {
+        return Dictionary();
+    }
+
+    Dictionary result;
+    if (vector_names.is_empty()) {
+        UtilityFunctions::printerr("get_spectra needs at least one vector name");
+        return result;
+    }
+
+    // All vectors share the first one's grid; samples are copied out of
+    // ngspice on this thread, the transforms run in parallel
+    int64_t size = points;
+    std::vector<std::vector<double>> samples(vector_names.size());
+    for (int i = 0; i < vector_names.size(); i++) {
+        if (!load_uniform_samples(vector_names[i], size, t0, t1, samples[i])) {
+            return result;
+        }
+    }
+
+    size_t bins = (size_t)size / 2 + 1;
+    std::vector<std::vector<double>> magnitudes(samples.size(), std::vector<double>(bins));
+    std::vector<std::vector<double>> phases(samples.size(), std::vector<double>(bins));
+
+    if (thread_count <= 0) {
+        thread_count = (int)std::thread::hardware_concurrency();
+    }
+    thread_count = std::max(1, std::min(thread_count, (int)samples.size()));
+    auto worker = [&](int index) {
+        for (size_t i = index; i < samples.size(); i += thread_count) {
+            SpectrumAnalyzer::analyze(samples[i].data(), (size_t)size, (SpectrumAnalyzer::Window)window,
+                magnitudes[i].data(), phases[i].data());
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_count; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    Array magnitude_list;
+    Array phase_list;
+    for (size_t i = 0; i < samples.size(); i++) {
+        PackedFloat64Array magnitude;
+        PackedFloat64Array phase;
+        magnitude.resize(bins);
+        phase.resize(bins);
+        memcpy(magnitude.ptrw(), magnitudes[i].data(), sizeof(double) * bins);
+        memcpy(phase.ptrw(), phases[i].data(), sizeof(double) * bins);
+        magnitude_list.append(magnitude);
+        phase_list.append(phase);
+    }
+
+    result["frequency"] = bin_frequencies(size, t0, t1);
+    result["names"] = vector_names;
+    result["magnitudes"] = magnitude_list;
+    result["phases"] = phase_list;
+    result["sample_rate"] = (double)size / (t1 - t0);
+    return result;
+}
+
+Dictionary CircuitSimulator::get_spectrogram(const String &vector_name, int frame_size, int hop,
+        SpectrumWindow window, int points, int thread_count) {
+    if (needs_local_library("get_spectrogram")) {
+        return Dictionary();
+    }
+
+    Dictionary result;
+    if (frame_size < 2 || !SpectrumAnalyzer::is_power_of_two((size_t)frame_size) || hop < 1) {
+        UtilityFunctions::printerr("Spectrogram frame size must be a power of two and hop positive");
+        return result;
+    }
+
+    int64_t size = points;
+    double t0 = 0.0;
+    double t1 = -1.0;
+    std::vector<double> samples;
+    if (!load_uniform_samples(vector_name, size, t0, t1, samples)) {
+        return result;
+    }
+
+    size_t frames = SpectrumAnalyzer::get_frame_count((size_t)size, (size_t)frame_size, (size_t)hop);
+    if (frames == 0) {
+        UtilityFunctions::printerr("Run is shorter than one spectrogram frame");
+        return result;
+    }
+
+    size_t bins = (size_t)frame_size / 2 + 1;
+    PackedFloat64Array magnitude;
+    magnitude.resize(frames * bins);
+    SpectrumAnalyzer::spectrogram(samples.data(), (size_t)size, (size_t)frame_size, (size_t)hop,
+        (SpectrumAnalyzer::Window)window, thread_count, magnitude.ptrw());
+
+    // Frame times are frame centres
+    double dt = (t1 - t0) / (double)size;
+    PackedFloat64Array times;
+    times.resize(frames);
+    for (size_t f = 0; f < frames; f++) {
+        times.set(f, t0 + dt * ((double)(f * hop) + frame_size * 0.5));
+    }
+
+    result["frequency"] = bin_frequencies(frame_size, 0.0, dt * frame_size);
+    result["times"] = times;
+    result["magnitude"] = magnitude;
+    result["frames"] = (int64_t)frames;
+    result["bins"] = (int64_t)bins;
+    return result;
+}
+
+static Dictionary comparison_result(const WaveformCompare::Result &result) {
+    Dictionary entry;
+    entry["passed"] = result.passed;
+    entry["points"] = (int64_t)result.points;
+    entry["coverage"] = result.coverage;
+    entry["t0"] = result.t0;
+    entry["t1"] = result.t1;
+    entry["max_error"] = result.max_error;
+    entry["max_error_time"] = result.max_error_time;
+    entry["rms_error"] = result.rms_error;
+    entry["violations"] = (int64_t)result.violations;
+    entry["first_fail_time"] = result.first_fail_time;
+    return entry;
+}
+
+static WaveformCompare::Settings comparison_settings(double absolute, double relative, double t0, double t1) {
+    WaveformCompare::Settings settings;
+    settings.absolute = absolute;
+    settings.relative = relative;
+    settings.t0 = t0;
+    settings.t1 = t1;
+    return settings;
+}
+
+Dictionary CircuitSimulator::compare_waveforms(const PackedFloat64Array &reference_time, const PackedFloat64Array &reference,
+        const PackedFloat64Array &time, const PackedFloat64Array &values, double absolute, double relative,
+        double t0, double t1) {
+    if (reference_time.size() != reference.size() || time.size() != values.size()) {
+        UtilityFunctions::printerr("Waveform time and value arrays must have the same length");
+        return Dictionary();
+    }
+
+    WaveformCompare::Pair pair;
+    pair.reference_time = reference_time.ptr();
+    pair.reference = reference.ptr();
+    pair.reference_count = (size_t)reference.size();
+    pair.time = time.ptr();
+    pair.values = values.ptr();
+    pair.count = (size_t)values.size();
+
+    WaveformCompare::Scratch scratch;
+    WaveformCompare::Result result = WaveformCompare::compare(pair, comparison_settings(absolute, relative, t0, t1), scratch);
+    if (!result.valid) {
+        UtilityFunctions::printerr("Waveforms do not overlap in time");
+        return Dictionary();
+    }
+    return comparison_result(result);
+}
+
+Dictionary CircuitSimulator::compare_to_golden(const Dictionary &golden, double absolute, double relative,
+        double t0, double t1, int thread_count) {
+    if (needs_local_library("compare_to_golden")) {
+        return Dictionary();
+    }
+
+    Dictionary result;
+    if (!initialized || !ngspice.get_vec_info) {
+        UtilityFunctions::printerr("ngspice not initialized");
+        return result;
+    }
+
+    // Vector data may be reallocated while ngspice appends to it
+    if (is_running()) {
+        UtilityFunctions::printerr("Cannot compare waveforms while a simulation is running");
+        return result;
+    }
+
+    if (!golden.has("time")) {
+        UtilityFunctions::printerr("Golden waveforms need a \"time\" array");
+        return result;
+    }
+    PackedFloat64Array golden_time = golden["time"];
+    const double *time;
+    size_t time_count;
+    if (!ngspice.find_real_vector("time", time, time_count)) {
+        UtilityFunctions::printerr("Golden comparison needs a transient result");
+        return result;
+    }
+
+    // Pairs point straight into ngspice's vectors and the golden arrays,
+    // which 'references' keeps alive until the batch is done
+    Array keys = golden.keys();
+    std::vector<PackedFloat64Array> references;
+    references.reserve(keys.size());
+    PackedStringArray names;
+    std::vector<WaveformCompare::Pair> pairs;
+    for (int i = 0; i < keys.size(); i++) {
+        String name = keys[i];
+        if (name == "time") {
+            continue;
+        }
+        PackedFloat64Array reference = golden[keys[i]];
+        if (reference.size() != golden_time.size()) {
+            UtilityFunctions::printerr("Golden vector does not match its time array: " + name);
+            return Dictionary();
+        }
+        CharString name_utf8 = name.utf8();
+        const double *values;
+        size_t count;
+        if (!ngspice.find_real_vector(name_utf8.get_data(), values, count) || count != time_count) {
+            UtilityFunctions::printerr("No transient vector named " + name);
+            return Dictionary();
+        }
+
+        references.push_back(reference);
+        names.push_back(name);
+        WaveformCompare::Pair pair;
+        pair.reference_time = golden_time.ptr();
+        pair.reference = references.back().ptr();
+        pair.reference_count = (size_t)golden_time.size();
+        pair.time = time;
+        pair.values = values;
+        pair.count = time_count;
+        pairs.push_back(pair);
+    }
+
+    std::vector<WaveformCompare::Result> results;
+    WaveformCompare::compare_batch(pairs, comparison_settings(absolute, relative, t0, t1), results, thread_count);
+
+    bool passed = true;
+    double first_fail_time = -1.0;
+    String first_fail_vector;
+    Dictionary vectors;
+    for (size_t i = 0; i < results.size(); i++) {
+        const WaveformCompare::Result &entry = results[i];
+        if (!entry.valid) {
+            UtilityFunctions::printerr("Golden and simulated waveforms do not overlap: " + names[i]);
+            return Dictionary();
+        }
+        vectors[names[i]] = comparison_result(entry);
+        if (!entry.passed) {
+            passed = false;
+            if (first_fail_time < 0.0 || entry.first_fail_time < first_fail_time) {
+                first_fail_time = entry.first_fail_time;
+                first_fail_vector = names[i];
+            }
+        }
+    }
+
+    result["passed"] = passed;
+    result["first_fail_time"] = first_fail_time;
+    result["first_fail_vector"] = first_fail_vector;
+    result["vectors"] = vectors;
+    return result;
+}
+
+Array CircuitSimulator::get_voltage(const String &node_name) {
+    if (worker_pool.is_started()) {
+        return get_worker_vector("v(" + node_name + ")");
+    }
+
+    Array result;
+
+    if (!initialized || !ngspice.get_vec_info) {
+        return result;
+    }
+
+    CharString name_utf8 = (String("v(") + node_name + ")").utf8();
+    pvector_info vec = ngspice.get_vec_info((char*)name_utf8.get_data());
+
+    if (vec && vec->v_realdata) {
+        for (int i = 0; i < vec->v_length; i++) {
+            result.append(vec->v_realdata[i]);
+        }
+    }
+
+    return result;
+}
+
+Array CircuitSimulator::get_current(const String &source_name) {
+    if (worker_pool.is_started()) {
+        return get_worker_vector("i(" + source_name + ")");
+    }
+
+    Array result;
+
+    if (!initialized || !ngspice.get_vec_info) {
+        return result;
+    }
+
+    CharString name_utf8 = (String("i(") + source_name + ")").utf8();
+    pvector_info vec = ngspice.get_vec_info((char*)name_utf8.get_data());
+
+    if (vec && vec->v_realdata) {
+        for (int i = 0; i < vec->v_length; i++) {
+            result.append(vec->v_realdata[i]);
+        }
+    }
+
+    return result;
+}
+
+Array CircuitSimulator::get_time_vector() {
+    if (worker_pool.is_started()) {
+        return get_worker_vector("time");
+    }
+
+    Array result;
+
+    if (!initialized || !ngspice.get_vec_info) {
+        return result;
+    }
+
+    pvector_info vec = ngspice.get_vec_info((char*)"time");
+
+    if (vec && vec->v_realdata) {
+        for (int i = 0; i < vec->v_length; i++) {
+            result.append(vec->v_realdata[i]);
+        }
+    }
+
+    return result;
+}
+
+Dictionary CircuitSimulator::get_all_vectors() {
+    if (needs_local_library("get_all_vectors")) {
+        return Dictionary();
+    }
+
+    Dictionary result;
+
+    if (!initialized || !ngspice.cur_plot || !ngspice.all_vecs) {
+        return result;
+    }
+
+    char* cur_plot = ngspice.cur_plot();
+    if (!cur_plot) {
+        return result;
+    }
+
+    char** all_vecs = ngspice.all_vecs(cur_plot);
+    if (!all_vecs) {
+        return result;
+    }
+
+    // Hand out lazy proxies; samples are copied only when a proxy is read
+    String plot_name = String(cur_plot);
+    for (int i = 0; all_vecs[i] != nullptr; i++) {
+        Ref<SimVector> vec;
+        vec.instantiate();
+        vec->setup(this, plot_name, String(all_vecs[i]));
+        result[vec->get_name()] = vec;
+    }
+
+    return result;
+}
+
+pvector_info CircuitSimulator::get_vector_info(const String &vector_name) {
+    if (!initialized || !ngspice.get_vec_info) {
+        return nullptr;
+    }
+
+    CharString name_utf8 = vector_name.utf8();
+    return ngspice.get_vec_info((char*)name_utf8.get_data());
+}
+
+PackedStringArray CircuitSimulator::get_all_vector_names() {
     PackedStringArray result;
 
-    if (!initialized || !ng_CurPlot || !ng_AllVecs) {
-        return result;
+    if (worker_pool.is_started()) {
+        for (const std::string &name : worker_result.vector_names) {
+            result.append(String(name.c_str()));
+        }
+        return result;
+    }
+
+    if (!initialized || !ngspice.cur_plot || !ngspice.all_vecs) {
+        return result;
+    }
+
+    char* cur_plot = ngspice.cur_plot();
+    if (!cur_plot) {
+        return result;
+    }
+
+    char** all_vecs = ngspice.all_vecs(cur_plot);
+    if (!all_vecs) {
+        return result;
+    }
+
+    for (int i = 0; all_vecs[i] != nullptr; i++) {
+        result.append(String(all_vecs[i]));
+    }
+
+    return result;
+}
+
+void CircuitSimulator::apply_probes() {
+    // Apply the probe set; this also clears a stop point left by a resumable transient
+    if (!debug_list_changed && probes.size() == 0) {
+        return;
+    }
+
+    std::string cmd = "save";
+    if (debug_list_changed) {
+        clear_debug_list();
+        append_netlist_saves(cmd);
+    }
+    for (int i = 0; i < probes.size(); i++) {
+        cmd += " ";
+        cmd += probes[i].utf8().get_data();
+    }
+    // With no probes the list is back to what the netlist set up
+    debug_list_changed = probes.size() > 0;
+    if (cmd.size() > 4 && ngspice.command((char*)cmd.c_str()) != 0) {
+        UtilityFunctions::printerr("Failed to apply probe set");
+    }
+}
+
+void CircuitSimulator::clear_debug_list() {
+    // ngspice deletes entries by number or all at once; the numbers are only
+    // listed in console text, so the whole list is cleared instead
+    ngspice.command((char*)"delete all");
+    debug_list_changed = true;
+    stop_point_set = false;
+}
+
+void CircuitSimulator::append_netlist_saves(std::string &cmd) const {
+    // Adds the arguments of the netlist's .save cards
+    for (const char *line : netlist_lines) {
+        line += strspn(line, " \t");
+        if ((strncmp(line, ".save", 5) == 0 || strncmp(line, ".SAVE", 5) == 0) && isspace((unsigned char)line[5])) {
+            cmd += " ";
+            cmd += line + 6;
+        }
     }
+}
 
-    char* cur_plot = ng_CurPlot();
-    if (!cur_plot) {
-        return result;
+void CircuitSimulator::set_probes(const PackedStringArray &probe_names) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+
+    probes = probe_names;
+    probe_keys.clear();
+    for (int i = 0; i < probes.size(); i++) {
+        probe_keys.push_back(probe_key(probes[i].utf8().get_data()));
     }
+}
 
-    char** all_vecs = ng_AllVecs(cur_plot);
-    if (!all_vecs) {
-        return result;
+PackedStringArray CircuitSimulator::get_probes() const {
+    return probes;
+}
+
+void CircuitSimulator::clear_probes() {
+    set_probes(PackedStringArray());
+}
+
+void CircuitSimulator::handle_init_data(pvecinfoall data) {
+    // Every run records a fresh log or replays the log from its start
+    {
+        std::lock_guard<std::mutex> source_lock(source_mutex);
+        if (source_mode == SOURCE_RECORDING) {
+            source_log.begin_recording();
+        } else if (source_mode == SOURCE_REPLAYING) {
+            source_log.begin_replay();
+        }
     }
 
-    for (int i = 0; all_vecs[i] != nullptr; i++) {
-        result.append(String(all_vecs[i]));
+    std::lock_guard<std::mutex> lock(stream_mutex);
+
+    stream_names.clear();
+    stream_keys.clear();
+    stream_probe_mask.assign(data->veccount, probe_keys.empty() ? 1 : 0);
+    for (int i = 0; i < data->veccount; i++) {
+        stream_names.push_back(data->vecs[i]->vecname);
+        stream_keys.push_back(String(data->vecs[i]->vecname));
+        if (!probe_keys.empty()) {
+            std::string key = probe_key(data->vecs[i]->vecname);
+            for (const std::string &probe : probe_keys) {
+                if (probe == key) {
+                    stream_probe_mask[i] = 1;
+                    break;
+                }
+            }
+        }
+    }
+    stream_row.assign(stream_names.size(), 0.0);
+    // Handlers that kept the last payload keep its values
+    stream_payload = Dictionary();
+    stream_configured = false;
+    snapshot_configured = false;
+    stream_scale = -1;
+    stream_time_scale = false;
+    stream_generation++;
+
+    // Each run starts its edge indexes over
+    for (EdgeWatch &watch : edge_watches) {
+        watch.column = -1;
+        for (size_t i = 0; i < stream_names.size(); i++) {
+            if (probe_key(stream_names[i].c_str()) == watch.key) {
+                watch.column = (int32_t)i;
+                break;
+            }
+        }
+        watch.index.reset();
+    }
+
+    std::lock_guard<std::mutex> trace_lock(trace_mutex);
+    if (convergence_tracing) {
+        convergence_trace.clear();
+        trace_clock = std::chrono::steady_clock::now();
+    }
+}
+
+void CircuitSimulator::handle_send_data(pvecvaluesall data) {
+    // The solver time of a step runs from the end of the previous callback
+    // to the start of this one, so our own work and the signal handlers
+    // are not charged to it
+    std::chrono::steady_clock::time_point arrived = std::chrono::steady_clock::now();
+
+    // Handlers may call back into the simulator (set_probes, get_edges, ...),
+    // so the signal is emitted after stream_mutex is released. The payload
+    // is only written on this thread.
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        store_stream_row(data, arrived);
+    }
+    emit_signal(data_ready_signal, stream_payload);
+
+    std::lock_guard<std::mutex> trace_lock(trace_mutex);
+    if (convergence_tracing) {
+        trace_clock = std::chrono::steady_clock::now();
+    }
+}
+
+void CircuitSimulator::store_stream_row(pvecvaluesall data, std::chrono::steady_clock::time_point arrived) {
+    // Only the probed vectors (and the scale) are passed on. Keys are the
+    // Strings made in handle_init_data, shared instead of converted per row,
+    // and existing entries are overwritten in place.
+    bool filtered = (size_t)data->veccount == stream_probe_mask.size();
+    bool keyed = (size_t)data->veccount == stream_keys.size();
+    for (int i = 0; i < data->veccount; i++) {
+        pvecvalues vec = data->vecsa[i];
+        if (!filtered || stream_probe_mask[i] || vec->is_scale) {
+            stream_payload[keyed ? stream_keys[i] : String(vec->name)] = vec->creal;
+        }
+    }
+
+    if ((size_t)data->veccount != stream_names.size()) {
+        return;
+    }
+    for (int i = 0; i < data->veccount; i++) {
+        stream_row[i] = data->vecsa[i]->creal;
+    }
+
+    if (stream_scale < 0) {
+        stream_scale = 0;
+        for (int i = 0; i < data->veccount; i++) {
+            if (data->vecsa[i]->is_scale) {
+                stream_scale = i;
+                break;
+            }
+        }
+        stream_time_scale = stream_names[stream_scale] == "time";
+    }
+
+    // Edge lookups are binary searches over time, so only a transient's
+    // scale is indexed; a dc sweep may run downwards and ac is not time
+    double scale_value = stream_row[stream_scale];
+    if (stream_time_scale) {
+        for (EdgeWatch &watch : edge_watches) {
+            if (watch.column >= 0) {
+                watch.index.append(scale_value, stream_row[watch.column]);
+            }
+        }
+    }
+
+    // One row at a time, so a snapshot never ends mid-row
+    if (snapshot_publishing) {
+        if (!snapshot_configured) {
+            std::vector<std::string> keys;
+            for (const std::string &name : stream_names) {
+                keys.push_back(probe_key(name.c_str()));
+            }
+            snapshot_publisher.reset(stream_names, keys, stream_scale, stream_generation);
+            snapshot_configured = true;
+        }
+        snapshot_publisher.append(stream_row.data());
+        snapshot_publisher.publish();
+    }
+
+    {
+        std::lock_guard<std::mutex> trace_lock(trace_mutex);
+        if (convergence_tracing) {
+            convergence_trace.add_point(scale_value, std::chrono::duration<double>(arrived - trace_clock).count());
+        }
+    }
+
+    if (!waveform_compression) {
+        return;
+    }
+
+    if (!stream_configured) {
+        waveform_store.reset(stream_names, stream_scale);
+        stream_configured = true;
+    }
+    waveform_store.append_row(stream_row.data());
+}
+
+void CircuitSimulator::read_latest_values(const std::vector<std::string> &names, uint64_t &generation,
+        std::vector<int32_t> &columns, std::vector<double> &values) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+
+    if (generation != stream_generation || columns.size() != names.size()) {
+        columns.assign(names.size(), -1);
+        for (size_t n = 0; n < names.size(); n++) {
+            std::string key = probe_key(names[n].c_str());
+            for (size_t i = 0; i < stream_names.size(); i++) {
+                if (probe_key(stream_names[i].c_str()) == key) {
+                    columns[n] = (int32_t)i;
+                    break;
+                }
+            }
+        }
+        generation = stream_generation;
+    }
+
+    values.resize(names.size());
+    for (size_t n = 0; n < names.size(); n++) {
+        int32_t column = columns[n];
+        values[n] = (column >= 0 && (size_t)column < stream_row.size()) ? stream_row[column] : 0.0;
+    }
+}
+
+void CircuitSimulator::set_waveform_compression(bool enabled) {
+    if (enabled && needs_local_library("set_waveform_compression")) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    waveform_compression = enabled;
+    if (!enabled) {
+        waveform_store.clear();
+        stream_configured = false;
+    }
+}
+
+bool CircuitSimulator::is_waveform_compression_enabled() const {
+    return waveform_compression;
+}
+
+Dictionary CircuitSimulator::get_compressed_range(const String &vector_name, double t0, double t1) {
+    Dictionary result;
+    std::vector<double> scale;
+    std::vector<double> values;
+
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        int index = waveform_store.find_vector(vector_name.utf8().get_data());
+        if (index < 0) {
+            return result;
+        }
+        waveform_store.read_range(index, t0, t1, scale, values);
+    }
+
+    PackedFloat64Array time_array;
+    PackedFloat64Array value_array;
+    time_array.resize((int64_t)scale.size());
+    value_array.resize((int64_t)values.size());
+    if (!scale.empty()) {
+        memcpy(time_array.ptrw(), scale.data(), scale.size() * sizeof(double));
+        memcpy(value_array.ptrw(), values.data(), values.size() * sizeof(double));
+    }
+
+    result["time"] = time_array;
+    result["values"] = value_array;
+    return result;
+}
+
+Dictionary CircuitSimulator::get_waveform_store_stats() {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+
+    Dictionary stats;
+    size_t raw_bytes = waveform_store.get_raw_bytes();
+    size_t compressed_bytes = waveform_store.get_compressed_bytes();
+
+    stats["vectors"] = (int64_t)waveform_store.get_names().size();
+    stats["samples"] = (int64_t)waveform_store.get_sample_count();
+    stats["raw_bytes"] = (int64_t)raw_bytes;
+    stats["compressed_bytes"] = (int64_t)compressed_bytes;
+    stats["compression_ratio"] = compressed_bytes > 0 ? (double)raw_bytes / (double)compressed_bytes : 0.0;
+    stats["decode_samples_per_second"] = waveform_store.get_decode_throughput();
+    return stats;
+}
+
+static Dictionary arena_stats(const SimArena::Stats &stats) {
+    Dictionary result;
+    result["heap_allocations"] = (int64_t)stats.heap_allocations;
+    result["allocations"] = (int64_t)stats.allocations;
+    result["resets"] = (int64_t)stats.resets;
+    result["bytes_used"] = (int64_t)stats.bytes_used;
+    result["bytes_reserved"] = (int64_t)stats.bytes_reserved;
+    return result;
+}
+
+Dictionary CircuitSimulator::get_allocation_stats() const {
+    Dictionary result;
+    result["netlist"] = arena_stats(netlist_arena.get_stats());
+    result["waveform"] = arena_stats(waveform_store.get_arena_stats());
+    return result;
+}
+
+void CircuitSimulator::set_snapshot_publishing(bool enabled) {
+    if (enabled && needs_local_library("set_snapshot_publishing")) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    snapshot_publishing = enabled;
+    snapshot_configured = false;
+    if (!enabled) {
+        snapshot_publisher.clear();
+    }
+}
+
+bool CircuitSimulator::is_snapshot_publishing() const {
+    return snapshot_publishing;
+}
+
+Ref<SimSnapshot> CircuitSimulator::get_snapshot(double time) {
+    // No lock: the published pointer is swapped atomically by the producer
+    std::shared_ptr<const StreamSnapshot> snapshot = snapshot_publisher.acquire();
+    if (!snapshot) {
+        return Ref<SimSnapshot>();
+    }
+    if (time >= 0.0) {
+        snapshot = snapshot->truncated(snapshot->count_rows_until(time));
+    }
+
+    Ref<SimSnapshot> result;
+    result.instantiate();
+    result->setup(snapshot);
+    return result;
+}
+
+void CircuitSimulator::handle_output(const char *text) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (convergence_tracing && ConvergenceTrace::is_solver_message(text)) {
+        convergence_trace.add_status(text);
+    }
+}
+
+void CircuitSimulator::handle_sync(double time, double delta, int location) {
+    // Location 0 is a new step; 1 and 2 redo the last one
+    if (location != ConvergenceTrace::REJECT_NONCONVERGENCE && location != ConvergenceTrace::REJECT_TRUNCATION) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (convergence_tracing) {
+        convergence_trace.add_rejection(time, delta, location);
+    }
+}
+
+void CircuitSimulator::register_sync_callbacks() {
+    if (!ngspice.init_sync) {
+        return;
+    }
+    ngspice.init_sync(ng_get_vsrc_data, nullptr, convergence_tracing ? ng_get_sync_data : nullptr, nullptr, this);
+}
+
+bool CircuitSimulator::set_convergence_tracing(bool enabled) {
+    if (enabled && needs_local_library("set_convergence_tracing")) {
+        return false;
     }
 
+    // ngSpice_Init_Sync must not swap callbacks under a running analysis
+    if (is_running()) {
+        UtilityFunctions::printerr("Cannot change convergence tracing while a simulation is running");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        convergence_tracing = enabled;
+        convergence_trace.clear();
+        trace_clock = std::chrono::steady_clock::now();
+    }
+    if (initialized) {
+        register_sync_callbacks();
+    }
+    return true;
+}
+
+bool CircuitSimulator::is_convergence_tracing() const {
+    return convergence_tracing;
+}
+
+template <typename Packed, typename T>
+static Packed pack_vector(const std::vector<T> &values) {
+    Packed packed;
+    packed.resize(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        packed.set(i, values[i]);
+    }
+    return packed;
+}
+
+Dictionary CircuitSimulator::get_convergence_trace() {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    const ConvergenceTrace &trace = convergence_trace;
+
+    PackedFloat64Array times;
+    times.resize(trace.get_point_count());
+    if (trace.get_point_count() > 0) {
+        memcpy(times.ptrw(), trace.get_times().data(), trace.get_point_count() * sizeof(double));
+    }
+    PackedFloat64Array reject_times;
+    reject_times.resize(trace.get_rejection_count());
+    if (trace.get_rejection_count() > 0) {
+        memcpy(reject_times.ptrw(), trace.get_reject_times().data(), trace.get_rejection_count() * sizeof(double));
+    }
+
+    PackedStringArray status_lines;
+    for (const std::string &line : trace.get_status_lines()) {
+        status_lines.push_back(String(line.c_str()));
+    }
+
+    Dictionary result;
+    result["time"] = times;
+    result["step"] = pack_vector<PackedFloat32Array>(trace.get_steps());
+    result["wall_time"] = pack_vector<PackedFloat32Array>(trace.get_wall_times());
+    result["rejected"] = pack_vector<PackedInt32Array>(trace.get_rejected());
+    result["reject_time"] = reject_times;
+    result["reject_step"] = pack_vector<PackedFloat32Array>(trace.get_reject_steps());
+    result["reject_reason"] = pack_vector<PackedByteArray>(trace.get_reject_reasons());
+    result["status_time"] = pack_vector<PackedFloat64Array>(trace.get_status_times());
+    result["status"] = status_lines;
+    result["total_wall_time"] = trace.get_total_wall_time();
+    return result;
+}
+
+Array CircuitSimulator::get_stiff_intervals(int count, int bins) {
+    std::vector<ConvergenceTrace::Interval> intervals;
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        convergence_trace.find_stiff_intervals(bins, count, intervals);
+    }
+
+    Array result;
+    for (const ConvergenceTrace::Interval &interval : intervals) {
+        Dictionary entry;
+        entry["t0"] = interval.t0;
+        entry["t1"] = interval.t1;
+        entry["points"] = (int64_t)interval.points;
+        entry["rejected"] = (int64_t)interval.rejected;
+        entry["wall_time"] = interval.wall_time;
+        entry["min_step"] = interval.min_step;
+        entry["share"] = interval.share;
+        result.append(entry);
+    }
+    return result;
+}
+
+void CircuitSimulator::clear_convergence_trace() {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    convergence_trace.clear();
+}
+
+CircuitSimulator::EdgeWatch *CircuitSimulator::find_edge_watch(const String &vector_name) {
+    std::string key = probe_key(vector_name.utf8().get_data());
+    for (EdgeWatch &watch : edge_watches) {
+        if (watch.key == key) {
+            return &watch;
+        }
+    }
+    return nullptr;
+}
+
+void CircuitSimulator::backfill_edges(EdgeWatch &watch, const String &vector_name) {
+    // Index a finished transient from the current plot; otherwise the
+    // index fills from the next run's stream
+    if (!initialized || !ngspice.get_vec_info || is_running()) {
+        return;
+    }
+    const double *time;
+    size_t time_count;
+    const double *values;
+    size_t count;
+    CharString name_utf8 = vector_name.utf8();
+    if (!ngspice.find_real_vector("time", time, time_count) || !ngspice.find_real_vector(name_utf8.get_data(), values, count) ||
+        count != time_count) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        watch.index.append(time[i], values[i]);
+    }
+}
+
+bool CircuitSimulator::set_edge_threshold(const String &vector_name, double low, double high) {
+    if (needs_local_library("set_edge_threshold")) {
+        return false;
+    }
+
+    if (!std::isfinite(low) || !std::isfinite(high)) {
+        UtilityFunctions::printerr("Edge thresholds must be finite");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    EdgeWatch *watch = find_edge_watch(vector_name);
+    if (!watch) {
+        EdgeWatch added;
+        added.key = probe_key(vector_name.utf8().get_data());
+        added.column = -1;
+        for (size_t i = 0; i < stream_names.size(); i++) {
+            if (probe_key(stream_names[i].c_str()) == added.key) {
+                added.column = (int32_t)i;
+                break;
+            }
+        }
+        edge_watches.push_back(added);
+        watch = &edge_watches.back();
+    }
+    watch->index.configure(low, high);
+    backfill_edges(*watch, vector_name);
+    return true;
+}
+
+void CircuitSimulator::remove_edge_threshold(const String &vector_name) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    EdgeWatch *watch = find_edge_watch(vector_name);
+    if (watch) {
+        edge_watches.erase(edge_watches.begin() + (watch - edge_watches.data()));
+    }
+}
+
+void CircuitSimulator::clear_edge_thresholds() {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    edge_watches.clear();
+}
+
+Dictionary CircuitSimulator::get_edges(const String &vector_name, double t0, double t1) {
+    Dictionary result;
+    std::vector<double> times;
+    std::vector<uint8_t> rising;
+
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        EdgeWatch *watch = find_edge_watch(vector_name);
+        if (!watch) {
+            UtilityFunctions::printerr("No edge threshold set for: " + vector_name);
+            return result;
+        }
+        watch->index.get_edges(t0, t1, times, rising);
+    }
+
+    PackedFloat64Array packed_times;
+    packed_times.resize(times.size());
+    if (!times.empty()) {
+        memcpy(packed_times.ptrw(), times.data(), times.size() * sizeof(double));
+    }
+    PackedByteArray packed_rising;
+    packed_rising.resize(rising.size());
+    if (!rising.empty()) {
+        memcpy(packed_rising.ptrw(), rising.data(), rising.size());
+    }
+
+    result["times"] = packed_times;
+    result["rising"] = packed_rising;
     return result;
 }
 
+int CircuitSimulator::get_edge_count(const String &vector_name, double t0, double t1) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    EdgeWatch *watch = find_edge_watch(vector_name);
+    return watch ? (int)watch->index.count_edges(t0, t1) : 0;
+}
+
+int CircuitSimulator::get_logic_state(const String &vector_name, double time) {
+    std::lock_guard<std::mutex> lock(stream_mutex);
+    EdgeWatch *watch = find_edge_watch(vector_name);
+    return watch ? (int)watch->index.state_at(time) : (int)EdgeIndex::STATE_UNKNOWN;
+}
+
 void CircuitSimulator::set_voltage_source(const String &source_name, double voltage) {
     voltage_sources[source_name] = voltage;
+    {
+        std::lock_guard<std::mutex> lock(source_mutex);
+        CharString name_utf8 = source_name.utf8();
+        bool found = false;
+        for (SourceValue &source : source_values) {
+            if (source.name == name_utf8.get_data()) {
+                source.value = voltage;
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            source_values.push_back({ std::string(name_utf8.get_data()), voltage });
+        }
+    }
     UtilityFunctions::print("Set " + source_name + " to " + String::num(voltage) + "V");
 }
 
@@ -500,3 +2653,120 @@ double CircuitSimulator::get_voltage_source(const String &source_name) {
     }
     return 0.0;
 }
+
+double CircuitSimulator::find_source_value(const char *source_name) const {
+    for (const SourceValue &source : source_values) {
+        if (strcmp(source.name.c_str(), source_name) == 0) {
+            return source.value;
+        }
+    }
+    return 0.0;
+}
+
+double CircuitSimulator::resolve_voltage_source(const char *source_name, double time) {
+    std::lock_guard<std::mutex> lock(source_mutex);
+
+    if (source_mode == SOURCE_LIVE) {
+        return find_source_value(source_name);
+    }
+
+    if (source_mode == SOURCE_REPLAYING) {
+        // Every callback advances the replay, also for sources not in the log
+        int index = source_log.find_source(source_name);
+        double value;
+        if (source_log.replay(index >= 0 ? (uint32_t)index : UINT32_MAX, value)) {
+            return value;
+        }
+        return find_source_value(source_name);
+    }
+
+    double value = find_source_value(source_name);
+    source_log.record(source_log.add_source(source_name), time, value);
+    return value;
+}
+
+void CircuitSimulator::start_source_recording() {
+    if (needs_local_library("start_source_recording")) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(source_mutex);
+    source_log.begin_recording();
+    source_mode = SOURCE_RECORDING;
+}
+
+PackedByteArray CircuitSimulator::stop_source_recording() {
+    {
+        std::lock_guard<std::mutex> lock(source_mutex);
+        if (source_mode == SOURCE_RECORDING) {
+            source_mode = SOURCE_LIVE;
+        }
+    }
+    return get_source_log();
+}
+
+bool CircuitSimulator::start_source_replay(const PackedByteArray &log) {
+    if (needs_local_library("start_source_replay")) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(source_mutex);
+
+    if (!source_log.deserialize(log.ptr(), (size_t)log.size())) {
+        UtilityFunctions::printerr("Invalid source log");
+        source_mode = SOURCE_LIVE;
+        return false;
+    }
+
+    source_mode = SOURCE_REPLAYING;
+    return true;
+}
+
+void CircuitSimulator::stop_source_replay() {
+    std::lock_guard<std::mutex> lock(source_mutex);
+    if (source_mode == SOURCE_REPLAYING) {
+        source_mode = SOURCE_LIVE;
+    }
+}
+
+bool CircuitSimulator::is_recording_sources() const {
+    return source_mode == SOURCE_RECORDING;
+}
+
+bool CircuitSimulator::is_replaying_sources() const {
+    return source_mode == SOURCE_REPLAYING;
+}
+
+PackedByteArray CircuitSimulator::get_source_log() {
+    std::vector<uint8_t> bytes;
+    {
+        std::lock_guard<std::mutex> lock(source_mutex);
+        source_log.serialize(bytes);
+    }
+
+    PackedByteArray result;
+    result.resize((int64_t)bytes.size());
+    if (!bytes.empty()) {
+        memcpy(result.ptrw(), bytes.data(), bytes.size());
+    }
+    return result;
+}
+
+Dictionary CircuitSimulator::get_source_events() {
+    std::lock_guard<std::mutex> lock(source_mutex);
+
+    PackedFloat64Array times;
+    PackedStringArray names;
+    PackedFloat64Array values;
+    for (const SourceEventLog::Event &event : source_log.get_events()) {
+        times.append(event.time);
+        names.append(String(source_log.get_sources()[event.source].c_str()));
+        values.append(event.value);
+    }
+
+    Dictionary result;
+    result["time"] = times;
+    result["source"] = names;
+    result["value"] = values;
+    return result;
+}
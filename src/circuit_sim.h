@@ -7,16 +7,29 @@
 #include <godot_cpp/variant/dictionary.hpp>
 #include <godot_cpp/variant/array.hpp>
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <dlfcn.h>
-#endif
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-#include "sharedspice.h"
+#include "convergence_trace.h"
+#include "edge_index.h"
+#include "netlist_graph.h"
+#include "ngspice_library.h"
+#include "sim_arena.h"
+#include "sim_process.h"
+#include "source_event_log.h"
+#include "spectrum.h"
+#include "stream_snapshot.h"
+#include "sweep_tensor.h"
+#include "waveform_compare.h"
+#include "waveform_store.h"
 
 namespace godot {
 
+class SimSnapshot;
+
 class CircuitSimulator : public Node {
     GDCLASS(CircuitSimulator, Node)
 
@@ -24,40 +37,197 @@ private:
     bool initialized;
     String current_netlist;
 
-    // Dynamic library handle
-#ifdef _WIN32
-    HMODULE ngspice_handle;
-#else
-    void* ngspice_handle;
-#endif
-
-    // Function pointers for ngspice API
-    int (*ng_Init)(SendChar*, SendStat*, ControlledExit*, SendData*, SendInitData*, BGThreadRunning*, void*);
-    int (*ng_Init_Sync)(GetVSRCData*, GetISRCData*, GetSyncData*, int*, void*);
-    int (*ng_Command)(char*);
-    pvector_info (*ng_GetVecInfo)(char*);
-    char* (*ng_CurPlot)();
-    char** (*ng_AllPlots)();
-    char** (*ng_AllVecs)(char*);
-    int (*ng_Circ)(char**);
-    bool (*ng_Running)();
+    // Dynamically loaded ngspice library and its entry points
+    NgspiceLibrary ngspice;
 
     // Load ngspice dynamically
     bool load_ngspice_library();
     void unload_ngspice_library();
 
-    // Voltage source values for interactive control
+    // Asynchronous initialization: library load and ngSpice_Init run on
+    // init_thread; calls made before it finishes are queued in pending_calls.
+    // Console output and errors of that thread are buffered in init_output
+    // and replayed on the main thread. init_generation is bumped by every
+    // start and by shutdown, so a stale or cancelled init is ignored.
+    bool initializing;
+    std::thread init_thread;
+    uint64_t init_generation;
+    bool init_succeeded;
+    Array pending_calls;
+    PackedStringArray pending_names;
+    std::mutex init_output_mutex;
+    bool init_buffering;
+    struct InitOutput {
+        std::string text;
+        bool error;
+    };
+    std::vector<InitOutput> init_output;
+    void report_error(const String &message);
+    void flush_init_output();
+    bool init_ngspice_instance(bool skip_spinit, const PackedStringArray &code_models);
+    bool queue_until_ready(const Callable &call, const char *method);
+    bool is_still_initializing(const char *method) const;
+    void _finish_async_init(bool success, uint64_t generation);
+
+    // Voltage source values for interactive control. source_values mirrors
+    // the dictionary for the vsrc callback, which looks names up with strcmp
+    // under source_mutex instead of building a String per call.
     Dictionary voltage_sources;
+    struct SourceValue {
+        std::string name;
+        double value;
+    };
+    std::vector<SourceValue> source_values;
+    double find_source_value(const char *source_name) const;
+
+    // Record/replay of external source values (see SourceEventLog)
+    enum SourceMode {
+        SOURCE_LIVE,
+        SOURCE_RECORDING,
+        SOURCE_REPLAYING
+    };
+    SourceMode source_mode;
+    std::mutex source_mutex;
+    SourceEventLog source_log;
+
+    // Netlist lines of the loaded circuit, kept so it can be re-submitted
+    // with .nodeset cards for a warm-started operating point. The text
+    // lives in netlist_arena, rewound on every load.
+    SimArena netlist_arena;
+    std::vector<char*> netlist_lines;
+    std::vector<char*> circ_lines;
+    void split_netlist(const CharString &text, std::vector<char*> &lines);
+    void resolve_include_paths(const std::string &base_dir);
+    bool submit_netlist_lines(const std::string &extra_card);
+
+    // alter commands from alter_component, re-applied when a warm start
+    // replaces the circuit (one entry per device and parameter)
+    struct AlterCommand {
+        std::string target;
+        std::string command;
+    };
+    std::vector<AlterCommand> alter_commands;
+    void reapply_alters();
+
+    // Resumable transient: the run is set up to 'transient_horizon' and held
+    // at 'transient_stop' with a breakpoint, so it can be extended in place.
+    // Step and start are kept to re-run it past the horizon.
+    double transient_step;
+    double transient_start;
+    double transient_stop;
+    double transient_horizon;
+    bool stop_point_set;
+    bool set_transient_breakpoint(double stop);
+    bool halt_background();
+
+    // Streaming state, written from the ngspice thread. The scale (time)
+    // column is only known from the first data row, hence stream_configured.
+    std::mutex stream_mutex;
+    std::vector<std::string> stream_names;
+    std::vector<double> stream_row;
+    std::vector<String> stream_keys;
+    bool stream_configured;
+    uint64_t stream_generation;
+    void store_stream_row(pvecvaluesall data, std::chrono::steady_clock::time_point arrived);
+
+    // simulation_data_ready payload. Its keys are added on the first row of
+    // an analysis and only overwritten after that, so emitting a row does
+    // not allocate; each analysis starts a new Dictionary.
+    Dictionary stream_payload;
+    StringName data_ready_signal;
+
+    // Active probe set: saved by ngspice and passed on by the streaming path
+    PackedStringArray probes;
+    std::vector<std::string> probe_keys;
+    std::vector<unsigned char> stream_probe_mask;
+    void apply_probes();
+
+    // Set once this class adds save/stop entries to the circuit's debug
+    // list. Until then the list only holds the netlist's .save cards; after
+    // that it is cleared with "delete all" and those cards are re-issued.
+    bool debug_list_changed;
+    void clear_debug_list();
+    void append_netlist_saves(std::string &cmd) const;
+
+    // Optional compressed copy of streamed vectors
+    bool waveform_compression;
+    WaveformStore waveform_store;
+
+    // Threshold-crossing indexes of watched vectors, fed from the stream.
+    // stream_scale is the scale column of the current run (-1 until the
+    // first row arrives); only runs whose scale is time are indexed.
+    struct EdgeWatch {
+        std::string key;
+        int32_t column;
+        EdgeIndex index;
+    };
+    std::vector<EdgeWatch> edge_watches;
+    int stream_scale;
+    bool stream_time_scale;
+    EdgeWatch *find_edge_watch(const String &vector_name);
+    void backfill_edges(EdgeWatch &watch, const String &vector_name);
+
+    // Immutable snapshots of the streamed rows, published after every row.
+    // The producer side runs under stream_mutex; readers never lock.
+    bool snapshot_publishing;
+    bool snapshot_configured;
+    SnapshotPublisher snapshot_publisher;
+
+    // Opt-in convergence profiling. The sync callback (which reports
+    // rejected steps) is only registered while tracing is on.
+    std::mutex trace_mutex;
+    bool convergence_tracing;
+    ConvergenceTrace convergence_trace;
+    std::chrono::steady_clock::time_point trace_clock;
+    void register_sync_callbacks();
+
+    // Last operating point solution (node voltages only)
+    PackedStringArray op_node_names;
+    PackedFloat64Array op_node_voltages;
+    String op_plot;
+
+    // Topology of the loaded netlist
+    NetlistGraph netlist_graph;
+
+    // Optional out-of-process backend: runs go to one sim_worker process,
+    // so an ngspice crash or controlled exit fails the run, not the game.
+    // worker_result holds the vectors of the last finished run's analysis.
+    SimProcessPool worker_pool;
+    double worker_timeout;
+    int worker_job;
+    SimAnalysis worker_result;
+    bool submit_worker_run(const std::string &analysis);
+    void poll_worker();
+    Array get_worker_vector(const String &vector_name) const;
+    // Calls without a worker route report an error instead of reading the
+    // idle in-process library
+    bool needs_local_library(const char *method) const;
+
+    // Vector of the current plot resampled onto a uniform time grid of
+    // 'points' samples (rounded up to a power of two, 0 = from the length)
+    bool load_uniform_samples(const String &vector_name, int64_t &points, double &t0, double &t1,
+        std::vector<double> &samples);
 
 protected:
     static void _bind_methods();
+    void _notification(int p_what);
 
 public:
+    enum SpectrumWindow {
+        WINDOW_RECTANGULAR = SpectrumAnalyzer::WINDOW_RECTANGULAR,
+        WINDOW_HANN = SpectrumAnalyzer::WINDOW_HANN,
+        WINDOW_HAMMING = SpectrumAnalyzer::WINDOW_HAMMING,
+        WINDOW_BLACKMAN = SpectrumAnalyzer::WINDOW_BLACKMAN,
+        WINDOW_FLAT_TOP = SpectrumAnalyzer::WINDOW_FLAT_TOP
+    };
+
     CircuitSimulator();
     ~CircuitSimulator();
 
     // Initialization
     bool initialize_ngspice();
+    bool initialize_ngspice_async(bool skip_spinit = false, const PackedStringArray &code_models = PackedStringArray());
+    bool is_initializing() const;
     void shutdown_ngspice();
     bool is_initialized() const;
 
@@ -73,21 +243,129 @@ public:
     void stop_simulation();
     bool is_running() const;
 
+    // Run analyses in a sim_worker process instead of the loaded library
+    bool set_worker_backend(bool enabled, const String &executable_path = "", const String &library_path = "",
+        double timeout = 0.0);
+    bool is_worker_backend() const;
+
+    // Pause / resume / extend a background transient run
+    bool run_transient_resumable(double step, double stop, double horizon, double start = 0.0);
+    bool extend_transient(double new_stop);
+    void pause_simulation();
+    bool resume_simulation();
+    double get_transient_stop() const;
+    double get_transient_horizon() const;
+
+    // Probes: only these vectors are saved and streamed (empty = all)
+    void set_probes(const PackedStringArray &probe_names);
+    PackedStringArray get_probes() const;
+    void clear_probes();
+
+    // Operating point (fast path for switch toggles)
+    Dictionary run_operating_point(bool warm_start = true);
+    bool alter_component(const String &device, double value, const String &parameter = "");
+
+    // Nested sweep (parameters outermost, up to two DC sources innermost)
+    // collected into one tensor shaped [output, axes...]
+    Ref<SweepTensor> run_sweep(const Array &axes, const PackedStringArray &outputs);
+
+    // Netlist topology and schematic layout
+    Dictionary get_netlist_graph() const;
+    Dictionary layout_netlist_graph(int iterations = 100, double spacing = 64.0, int thread_count = 0, bool include_ground = false);
+
+    // Spectrum of transient results (t1 < 0 = end of the run)
+    Dictionary get_spectrum(const String &vector_name, int points = 0, SpectrumWindow window = WINDOW_HANN,
+        double t0 = 0.0, double t1 = -1.0);
+    Dictionary get_spectra(const PackedStringArray &vector_names, int points = 0, SpectrumWindow window = WINDOW_HANN,
+        double t0 = 0.0, double t1 = -1.0, int thread_count = 0);
+    Dictionary get_spectrogram(const String &vector_name, int frame_size = 1024, int hop = 256,
+        SpectrumWindow window = WINDOW_HANN, int points = 0, int thread_count = 0);
+
+    // Golden-waveform checks: error of a waveform against a reference on the
+    // union of both time bases, with a band of absolute + relative * |reference|
+    Dictionary compare_waveforms(const PackedFloat64Array &reference_time, const PackedFloat64Array &reference,
+        const PackedFloat64Array &time, const PackedFloat64Array &values, double absolute = 1e-3,
+        double relative = 0.0, double t0 = 0.0, double t1 = -1.0);
+    Dictionary compare_to_golden(const Dictionary &golden, double absolute = 1e-3, double relative = 0.0,
+        double t0 = 0.0, double t1 = -1.0, int thread_count = 0);
+
     // Data retrieval
     Array get_voltage(const String &node_name);
     Array get_current(const String &source_name);
     Array get_time_vector();
     Dictionary get_all_vectors();
     PackedStringArray get_all_vector_names();
+    pvector_info get_vector_info(const String &vector_name);
+
+    // Compressed waveform store
+    void set_waveform_compression(bool enabled);
+    bool is_waveform_compression_enabled() const;
+    Dictionary get_compressed_range(const String &vector_name, double t0, double t1);
+    Dictionary get_waveform_store_stats();
+
+    // Logic edges of streamed vectors, with hysteresis between 'low' and
+    // 'high'. States are 1 (high), 0 (low) and -1 (not yet defined).
+    bool set_edge_threshold(const String &vector_name, double low, double high);
+    void remove_edge_threshold(const String &vector_name);
+    void clear_edge_thresholds();
+    Dictionary get_edges(const String &vector_name, double t0, double t1);
+    int get_edge_count(const String &vector_name, double t0, double t1);
+    int get_logic_state(const String &vector_name, double time);
+
+    // Convergence profiler: per accepted timepoint step size, wall time and
+    // rejected attempts, plus solver messages
+    bool set_convergence_tracing(bool enabled);
+    bool is_convergence_tracing() const;
+    Dictionary get_convergence_trace();
+    Array get_stiff_intervals(int count = 5, int bins = 100);
+    void clear_convergence_trace();
+
+    // Snapshots of streamed vectors, readable from any thread while the run
+    // continues (time < 0 = everything published so far)
+    void set_snapshot_publishing(bool enabled);
+    bool is_snapshot_publishing() const;
+    Ref<SimSnapshot> get_snapshot(double time = -1.0);
+
+    // Arena usage; heap_allocations stays flat once runs fit in earlier
+    // chunks. Per streamed row, the signal payload, source callbacks and
+    // snapshot publishing do not allocate either (see the class notes).
+    Dictionary get_allocation_stats() const;
 
     // Interactive control (for switches)
     void set_voltage_source(const String &source_name, double voltage);
     double get_voltage_source(const String &source_name);
 
-    // Static instance for callbacks
-    static CircuitSimulator* instance;
+    // Deterministic record/replay of source changes
+    void start_source_recording();
+    PackedByteArray stop_source_recording();
+    bool start_source_replay(const PackedByteArray &log);
+    void stop_source_replay();
+    bool is_recording_sources() const;
+    bool is_replaying_sources() const;
+    PackedByteArray get_source_log();
+    Dictionary get_source_events();
+
+    // Source value seen by ngspice, honoring record/replay
+    double resolve_voltage_source(const char *source_name, double time);
+
+    // Key on which probe and vector names are matched
+    static std::string probe_key(const char *name);
+
+    // Latest streamed value of each named vector (0 if not streamed).
+    // 'columns' caches the lookup and is rebuilt when 'generation' is stale.
+    void read_latest_values(const std::vector<std::string> &names, uint64_t &generation,
+        std::vector<int32_t> &columns, std::vector<double> &values);
+
+    // Streaming hooks, called from the ngspice callbacks
+    void handle_init_data(pvecinfoall data);
+    void handle_send_data(pvecvaluesall data);
+    void handle_output(const char *text);
+    bool defer_init_output(const char *text);
+    void handle_sync(double time, double delta, int location);
 };
 
 } // namespace godot
 
+VARIANT_ENUM_CAST(CircuitSimulator::SpectrumWindow);
+
 #endif // CIRCUIT_SIM_H
@@ -0,0 +1,135 @@
+#include "convergence_trace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+ConvergenceTrace::ConvergenceTrace() {
+    clear();
+}
+
+void ConvergenceTrace::clear() {
+    times.clear();
+    steps.clear();
+    wall_times.clear();
+    rejected.clear();
+    reject_times.clear();
+    reject_steps.clear();
+    reject_reasons.clear();
+    pending_rejects = 0;
+    status_times.clear();
+    status_lines.clear();
+    total_wall_time = 0.0;
+}
+
+void ConvergenceTrace::add_point(double time, double wall_time) {
+    double step = times.empty() ? 0.0 : time - times.back();
+    times.push_back(time);
+    steps.push_back((float)step);
+    wall_times.push_back((float)wall_time);
+    rejected.push_back((uint16_t)std::min<uint32_t>(pending_rejects, UINT16_MAX));
+    pending_rejects = 0;
+    total_wall_time += wall_time;
+}
+
+void ConvergenceTrace::add_rejection(double time, double step, int reason) {
+    reject_times.push_back(time);
+    reject_steps.push_back((float)step);
+    reject_reasons.push_back((uint8_t)reason);
+    pending_rejects++;
+}
+
+void ConvergenceTrace::add_status(const char *text) {
+    status_times.push_back(times.empty() ? 0.0 : times.back());
+    status_lines.push_back(text);
+}
+
+bool ConvergenceTrace::is_solver_message(const char *text) {
+    static const char *const KEYWORDS[] = {
+        "timestep too small", "gmin", "source step", "convergence", "singular matrix",
+        "trouble", "iteration limit", "time step"
+    };
+
+    std::string lower(text);
+    for (char &c : lower) {
+        c = (char)tolower((unsigned char)c);
+    }
+    for (const char *keyword : KEYWORDS) {
+        if (lower.find(keyword) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ConvergenceTrace::find_stiff_intervals(int bins, int count, std::vector<Interval> &intervals) const {
+    intervals.clear();
+    if (times.size() < 2 || bins <= 0 || count <= 0) {
+        return;
+    }
+
+    double start = times.front();
+    double span = times.back() - start;
+    if (!(span > 0.0)) {
+        return;
+    }
+
+    std::vector<Interval> slices(bins);
+    for (int b = 0; b < bins; b++) {
+        Interval &slice = slices[b];
+        slice.t0 = start + span * b / bins;
+        slice.t1 = start + span * (b + 1) / bins;
+        slice.points = 0;
+        slice.rejected = 0;
+        slice.wall_time = 0.0;
+        slice.min_step = std::numeric_limits<double>::infinity();
+        slice.share = 0.0;
+    }
+
+    // The first point has no step; it only carries setup time
+    for (size_t i = 1; i < times.size(); i++) {
+        int b = std::min(bins - 1, (int)((times[i] - start) / span * bins));
+        Interval &slice = slices[b];
+        slice.points++;
+        slice.rejected += rejected[i];
+        slice.wall_time += wall_times[i];
+        slice.min_step = std::min(slice.min_step, (double)steps[i]);
+    }
+
+    // The most expensive slices, then runs of neighbouring picks merged
+    std::vector<int> order(bins);
+    for (int b = 0; b < bins; b++) {
+        order[b] = b;
+    }
+    int picks = std::min(count, bins);
+    std::partial_sort(order.begin(), order.begin() + picks, order.end(),
+        [&slices](int a, int b) { return slices[a].wall_time > slices[b].wall_time; });
+
+    std::vector<uint8_t> picked(bins, 0);
+    for (int i = 0; i < picks; i++) {
+        if (slices[order[i]].points > 0) {
+            picked[order[i]] = 1;
+        }
+    }
+
+    for (int b = 0; b < bins; b++) {
+        if (!picked[b]) {
+            continue;
+        }
+        Interval merged = slices[b];
+        while (b + 1 < bins && picked[b + 1]) {
+            b++;
+            const Interval &next = slices[b];
+            merged.t1 = next.t1;
+            merged.points += next.points;
+            merged.rejected += next.rejected;
+            merged.wall_time += next.wall_time;
+            merged.min_step = std::min(merged.min_step, next.min_step);
+        }
+        merged.share = total_wall_time > 0.0 ? merged.wall_time / total_wall_time : 0.0;
+        intervals.push_back(merged);
+    }
+
+    std::sort(intervals.begin(), intervals.end(),
+        [](const Interval &a, const Interval &b) { return a.wall_time > b.wall_time; });
+}
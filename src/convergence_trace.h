@@ -0,0 +1,82 @@
+#ifndef CONVERGENCE_TRACE_H
+#define CONVERGENCE_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-timepoint record of a transient run: where the solver went, how big
+// its steps were and how long each took on the wall clock. Columns are
+// kept apart (time as double, the rest as float or int) so the trace stays
+// small and hands over as packed arrays without conversion.
+class ConvergenceTrace {
+public:
+    // Where ngspice's sync callback reported a step being redone
+    enum RejectReason {
+        REJECT_NONCONVERGENCE = 1,  // Newton iteration failed, step cut
+        REJECT_TRUNCATION = 2       // Local truncation error too large
+    };
+
+    struct Interval {
+        double t0;
+        double t1;
+        uint32_t points;
+        uint32_t rejected;
+        double wall_time;
+        double min_step;
+        double share;  // Fraction of the run's wall time
+    };
+
+private:
+    // Accepted timepoints
+    std::vector<double> times;
+    std::vector<float> steps;
+    std::vector<float> wall_times;
+    std::vector<uint16_t> rejected;
+
+    // Rejected step attempts
+    std::vector<double> reject_times;
+    std::vector<float> reject_steps;
+    std::vector<uint8_t> reject_reasons;
+    uint32_t pending_rejects;
+
+    // Solver messages (gmin/source stepping, timestep too small, ...)
+    std::vector<double> status_times;
+    std::vector<std::string> status_lines;
+
+    double total_wall_time;
+
+public:
+    ConvergenceTrace();
+
+    void clear();
+
+    void add_point(double time, double wall_time);
+    void add_rejection(double time, double step, int reason);
+    void add_status(const char *text);
+
+    // True for console lines worth keeping in the trace
+    static bool is_solver_message(const char *text);
+
+    size_t get_point_count() const { return times.size(); }
+    size_t get_rejection_count() const { return reject_times.size(); }
+    double get_total_wall_time() const { return total_wall_time; }
+
+    const std::vector<double> &get_times() const { return times; }
+    const std::vector<float> &get_steps() const { return steps; }
+    const std::vector<float> &get_wall_times() const { return wall_times; }
+    const std::vector<uint16_t> &get_rejected() const { return rejected; }
+    const std::vector<double> &get_reject_times() const { return reject_times; }
+    const std::vector<float> &get_reject_steps() const { return reject_steps; }
+    const std::vector<uint8_t> &get_reject_reasons() const { return reject_reasons; }
+    const std::vector<double> &get_status_times() const { return status_times; }
+    const std::vector<std::string> &get_status_lines() const { return status_lines; }
+
+    // Splits the simulated time span into 'bins' equal slices, picks the
+    // 'count' that took the most wall time and merges neighbours among
+    // them. Result is ordered by wall time, largest first.
+    void find_stiff_intervals(int bins, int count, std::vector<Interval> &intervals) const;
+};
+
+#endif // CONVERGENCE_TRACE_H
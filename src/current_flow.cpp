@@ -0,0 +1,298 @@
+#include "current_flow.h"
+#include "circuit_sim.h"
+
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace godot;
+
+// Distance past a segment start (in wire units) over which a particle turns
+static const float TURN_EPSILON = 1e-3f;
+
+void CurrentFlow::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("set_simulator", "simulator"), &CurrentFlow::set_simulator);
+    ClassDB::bind_method(D_METHOD("add_wire", "points", "branch", "sign"), &CurrentFlow::add_wire, DEFVAL(1.0));
+    ClassDB::bind_method(D_METHOD("clear"), &CurrentFlow::clear);
+    ClassDB::bind_method(D_METHOD("get_wire_count"), &CurrentFlow::get_wire_count);
+
+    ClassDB::bind_method(D_METHOD("set_particle_spacing", "spacing"), &CurrentFlow::set_particle_spacing);
+    ClassDB::bind_method(D_METHOD("get_particle_spacing"), &CurrentFlow::get_particle_spacing);
+    ClassDB::bind_method(D_METHOD("set_speed_scale", "scale"), &CurrentFlow::set_speed_scale);
+    ClassDB::bind_method(D_METHOD("get_speed_scale"), &CurrentFlow::get_speed_scale);
+    ClassDB::bind_method(D_METHOD("set_max_speed", "speed"), &CurrentFlow::set_max_speed);
+    ClassDB::bind_method(D_METHOD("get_max_speed"), &CurrentFlow::get_max_speed);
+
+    ClassDB::bind_method(D_METHOD("set_currents", "currents"), &CurrentFlow::set_currents);
+    ClassDB::bind_method(D_METHOD("get_currents"), &CurrentFlow::get_currents);
+
+    ClassDB::bind_method(D_METHOD("update", "delta"), &CurrentFlow::update);
+    ClassDB::bind_method(D_METHOD("get_instance_count"), &CurrentFlow::get_instance_count);
+    ClassDB::bind_method(D_METHOD("get_buffer"), &CurrentFlow::get_buffer);
+}
+
+CurrentFlow::CurrentFlow() {
+    spacing = 16.0f;
+    speed_scale = 1000.0f;
+    max_speed = 400.0f;
+    stream_generation = 0;
+    wire_segment_start.push_back(0);
+    wire_particle_start.push_back(0);
+}
+
+void CurrentFlow::set_simulator(Object *simulator) {
+    CircuitSimulator *sim = Object::cast_to<CircuitSimulator>(simulator);
+    simulator_id = sim ? ObjectID(sim->get_instance_id()) : ObjectID();
+    stream_generation = 0;
+    stream_columns.clear();
+}
+
+int CurrentFlow::add_wire(const PackedVector2Array &points, const String &branch, double sign) {
+    if (points.size() < 2) {
+        UtilityFunctions::printerr("A wire needs at least two points");
+        return -1;
+    }
+
+    float length = 0.0f;
+    for (int i = 0; i + 1 < points.size(); i++) {
+        Vector2 from = points[i];
+        Vector2 to = points[i + 1];
+        float dx = to.x - from.x;
+        float dy = to.y - from.y;
+        float segment_length = std::sqrt(dx * dx + dy * dy);
+        if (segment_length <= 0.0f) {
+            continue;
+        }
+        segment_x.push_back(from.x);
+        segment_y.push_back(from.y);
+        segment_dx.push_back(dx / segment_length);
+        segment_dy.push_back(dy / segment_length);
+        segment_begin.push_back(length);
+        segment_lengths.push_back(segment_length);
+        length += segment_length;
+    }
+    if (length <= 0.0f) {
+        UtilityFunctions::printerr("Wire has zero length");
+        return -1;
+    }
+
+    wire_branches.push_back(branch.utf8().get_data());
+    wire_signs.push_back(sign < 0.0 ? -1.0f : 1.0f);
+    wire_lengths.push_back(length);
+    wire_segment_start.push_back((int32_t)segment_x.size());
+    wire_currents.push_back(0.0f);
+    stream_columns.clear();
+
+    // Only the new wire is placed; particles on the others keep their offsets
+    size_t w = wire_lengths.size() - 1;
+    append_particles(w);
+    buffer.resize(particle_offset.size() * 8);
+    advance_wire(w, 0.0f);
+    write_transforms(wire_particle_start[w], wire_particle_start[w + 1]);
+    return (int)w;
+}
+
+void CurrentFlow::clear() {
+    wire_branches.clear();
+    wire_signs.clear();
+    wire_lengths.clear();
+    wire_segment_start.assign(1, 0);
+    wire_particle_start.assign(1, 0);
+    wire_currents.clear();
+    segment_x.clear();
+    segment_y.clear();
+    segment_dx.clear();
+    segment_dy.clear();
+    segment_begin.clear();
+    segment_lengths.clear();
+    stream_columns.clear();
+    layout_particles();
+}
+
+int CurrentFlow::get_wire_count() const {
+    return (int)wire_lengths.size();
+}
+
+void CurrentFlow::append_particles(size_t w) {
+    // Evenly spaced along the wire, at least one particle
+    int32_t begin = wire_particle_start.back();
+    int32_t count = std::max<int32_t>(1, (int32_t)(wire_lengths[w] / spacing));
+    wire_particle_start.push_back(begin + count);
+
+    size_t total = begin + count;
+    particle_offset.resize(total);
+    particle_x.resize(total);
+    particle_y.resize(total);
+    particle_cos.resize(total);
+    particle_sin.resize(total);
+    float gap = wire_lengths[w] / (float)count;
+    for (int32_t i = 0; i < count; i++) {
+        particle_offset[begin + i] = gap * (float)i;
+    }
+}
+
+void CurrentFlow::layout_particles() {
+    // All wires from scratch, so every particle goes back to its start
+    wire_particle_start.assign(1, 0);
+    particle_offset.clear();
+    particle_x.clear();
+    particle_y.clear();
+    particle_cos.clear();
+    particle_sin.clear();
+    for (size_t w = 0; w < wire_lengths.size(); w++) {
+        append_particles(w);
+    }
+
+    buffer.resize(particle_offset.size() * 8);
+    update(0.0);
+}
+
+void CurrentFlow::set_particle_spacing(double p_spacing) {
+    spacing = (float)std::max(p_spacing, 0.5);
+    layout_particles();
+}
+
+double CurrentFlow::get_particle_spacing() const {
+    return spacing;
+}
+
+void CurrentFlow::set_speed_scale(double scale) {
+    speed_scale = (float)scale;
+}
+
+double CurrentFlow::get_speed_scale() const {
+    return speed_scale;
+}
+
+void CurrentFlow::set_max_speed(double speed) {
+    max_speed = (float)std::max(speed, 0.0);
+}
+
+double CurrentFlow::get_max_speed() const {
+    return max_speed;
+}
+
+void CurrentFlow::set_currents(const PackedFloat64Array &currents) {
+    for (size_t w = 0; w < wire_currents.size() && w < (size_t)currents.size(); w++) {
+        wire_currents[w] = (float)currents[w];
+    }
+}
+
+PackedFloat64Array CurrentFlow::get_currents() const {
+    PackedFloat64Array result;
+    result.resize(wire_currents.size());
+    for (size_t w = 0; w < wire_currents.size(); w++) {
+        result.set(w, wire_currents[w]);
+    }
+    return result;
+}
+
+void CurrentFlow::update(double delta) {
+    // Latest streamed currents, one locked read per frame
+    if (simulator_id.is_valid()) {
+        CircuitSimulator *sim = Object::cast_to<CircuitSimulator>(ObjectDB::get_instance(simulator_id));
+        if (sim) {
+            sim->read_latest_values(wire_branches, stream_generation, stream_columns, stream_values);
+            for (size_t w = 0; w < wire_currents.size(); w++) {
+                wire_currents[w] = (float)stream_values[w];
+            }
+        }
+    }
+
+    for (size_t w = 0; w < wire_lengths.size(); w++) {
+        advance_wire(w, (float)delta);
+    }
+    write_transforms(0, (int32_t)particle_offset.size());
+}
+
+void CurrentFlow::advance_wire(size_t w, float dt) {
+    float *offset = particle_offset.data();
+    float *px = particle_x.data();
+    float *py = particle_y.data();
+    float *pc = particle_cos.data();
+    float *ps = particle_sin.data();
+
+    // The loops below avoid float compares and branches (min/max and int
+    // truncation only), which is what lets them vectorize without fast-math
+    const int32_t begin = wire_particle_start[w];
+    const int32_t end = wire_particle_start[w + 1];
+    const float length = wire_lengths[w];
+    const float inv_length = 1.0f / length;
+
+    float speed = wire_currents[w] * wire_signs[w] * speed_scale;
+    speed = std::min(std::max(speed, -max_speed), max_speed);
+    const float facing = speed < 0.0f ? -1.0f : 1.0f;
+
+    // Step reduced to (-length, length), shifted so the sum stays positive
+    // and the wrap is a truncation
+    const float shift = std::fmod(speed * dt, length) + length;
+    for (int32_t i = begin; i < end; i++) {
+        float o = offset[i] + shift;
+        o -= length * (float)(int32_t)(o * inv_length);
+        offset[i] = std::min(std::max(o, 0.0f), length);
+    }
+
+    // Position is the start point plus each segment's direction times the
+    // part of it already covered. The direction switches to a segment's
+    // own once a particle is past its start (a clamped ramp, 0 to 1 over TURN_EPSILON).
+    const int32_t first = wire_segment_start[w];
+    const int32_t last = wire_segment_start[w + 1];
+    {
+        const float sx = segment_x[first], sy = segment_y[first];
+        const float dx = segment_dx[first] * facing, dy = segment_dy[first] * facing;
+        for (int32_t i = begin; i < end; i++) {
+            px[i] = sx;
+            py[i] = sy;
+            pc[i] = dx;
+            ps[i] = dy;
+        }
+    }
+    for (int32_t s = first; s < last; s++) {
+        const float dx = segment_dx[s], dy = segment_dy[s];
+        const float start = segment_begin[s];
+        const float segment_length = segment_lengths[s];
+        const float turn_x = s > first ? (dx - segment_dx[s - 1]) * facing : 0.0f;
+        const float turn_y = s > first ? (dy - segment_dy[s - 1]) * facing : 0.0f;
+        const float ramp = std::min(segment_length, TURN_EPSILON);
+        const float inv_ramp = 1.0f / ramp;
+        for (int32_t i = begin; i < end; i++) {
+            float d = offset[i] - start;
+            float covered = std::min(std::max(d, 0.0f), segment_length);
+            float past = std::min(covered, ramp) * inv_ramp;
+            px[i] += covered * dx;
+            py[i] += covered * dy;
+            pc[i] += past * turn_x;
+            ps[i] += past * turn_y;
+        }
+    }
+}
+
+void CurrentFlow::write_transforms(int32_t begin, int32_t end) {
+    const float *px = particle_x.data();
+    const float *py = particle_y.data();
+    const float *pc = particle_cos.data();
+    const float *ps = particle_sin.data();
+
+    // MultiMesh 2D layout: basis.x.x, basis.y.x, pad, origin.x, basis.x.y, basis.y.y, pad, origin.y
+    float *out = buffer.ptrw();
+    for (int32_t i = begin; i < end; i++) {
+        float *row = out + (int64_t)i * 8;
+        row[0] = pc[i];
+        row[1] = -ps[i];
+        row[2] = 0.0f;
+        row[3] = px[i];
+        row[4] = ps[i];
+        row[5] = pc[i];
+        row[6] = 0.0f;
+        row[7] = py[i];
+    }
+}
+
+int CurrentFlow::get_instance_count() const {
+    return (int)particle_offset.size();
+}
+
+PackedFloat32Array CurrentFlow::get_buffer() const {
+    return buffer;
+}
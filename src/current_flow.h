@@ -0,0 +1,103 @@
+#ifndef CURRENT_FLOW_H
+#define CURRENT_FLOW_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/object_id.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <string>
+#include <vector>
+
+namespace godot {
+
+class CircuitSimulator;
+
+// Moves current-flow particles along wire polylines and writes their
+// transforms straight into a MultiMesh buffer (2D transform format, 8 floats
+// per instance). Currents come from the latest streamed row of a
+// CircuitSimulator, or from set_currents(). Particle state is kept as flat
+// arrays grouped by wire, so the per-frame loops run without branches or
+// gathers and are vectorized by the compiler.
+class CurrentFlow : public RefCounted {
+    GDCLASS(CurrentFlow, RefCounted)
+
+private:
+    ObjectID simulator_id;
+
+    // Wires: branch vector, direction sign, polyline segments and particles
+    std::vector<std::string> wire_branches;
+    std::vector<float> wire_signs;
+    std::vector<float> wire_lengths;
+    std::vector<int32_t> wire_segment_start;  // Size wire count + 1
+    std::vector<int32_t> wire_particle_start; // Size wire count + 1
+    std::vector<float> wire_currents;
+
+    // Segments of all wires: start point, unit direction, distance from wire start, length
+    std::vector<float> segment_x;
+    std::vector<float> segment_y;
+    std::vector<float> segment_dx;
+    std::vector<float> segment_dy;
+    std::vector<float> segment_begin;
+    std::vector<float> segment_lengths;
+
+    // Particles (SoA)
+    std::vector<float> particle_offset;
+    std::vector<float> particle_x;
+    std::vector<float> particle_y;
+    std::vector<float> particle_cos;
+    std::vector<float> particle_sin;
+
+    float spacing;
+    float speed_scale;
+    float max_speed;
+
+    // Stream column of each wire's branch, re-resolved when a new analysis starts
+    uint64_t stream_generation;
+    std::vector<int32_t> stream_columns;
+    std::vector<double> stream_values;
+
+    PackedFloat32Array buffer;
+
+    // Particles of one new wire, appended at its start
+    void append_particles(size_t w);
+    // Re-spaces every wire; only needed when the spacing changes
+    void layout_particles();
+    void advance_wire(size_t w, float dt);
+    void write_transforms(int32_t begin, int32_t end);
+
+protected:
+    static void _bind_methods();
+
+public:
+    CurrentFlow();
+
+    void set_simulator(Object *simulator);
+
+    // Returns the wire index. 'branch' is a current vector such as "i(v1)"
+    // or "v1#branch"; 'sign' flips the direction of flow along the polyline.
+    int add_wire(const PackedVector2Array &points, const String &branch, double sign = 1.0);
+    void clear();
+    int get_wire_count() const;
+
+    void set_particle_spacing(double p_spacing);
+    double get_particle_spacing() const;
+    void set_speed_scale(double scale);
+    double get_speed_scale() const;
+    void set_max_speed(double speed);
+    double get_max_speed() const;
+
+    // Manual feed, one current per wire (used when no simulator is set)
+    void set_currents(const PackedFloat64Array &currents);
+    PackedFloat64Array get_currents() const;
+
+    // Advance by 'delta' seconds and refresh the buffer
+    void update(double delta);
+
+    int get_instance_count() const;
+    PackedFloat32Array get_buffer() const;
+};
+
+} // namespace godot
+
+#endif // CURRENT_FLOW_H
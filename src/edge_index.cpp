@@ -0,0 +1,88 @@
+#include "edge_index.h"
+
+#include <algorithm>
+
+EdgeIndex::EdgeIndex() {
+    low = 0.5;
+    high = 0.5;
+    reset();
+}
+
+void EdgeIndex::configure(double p_low, double p_high) {
+    low = std::min(p_low, p_high);
+    high = std::max(p_low, p_high);
+    reset();
+}
+
+void EdgeIndex::reset() {
+    initial_state = STATE_UNKNOWN;
+    defined_from = 0.0;
+    state = STATE_UNKNOWN;
+    last_time = 0.0;
+    last_value = 0.0;
+    edge_times.clear();
+    edge_rising.clear();
+}
+
+void EdgeIndex::append(double time, double value) {
+    if (state == STATE_UNKNOWN) {
+        // Settling out of the band is not an edge
+        if (value >= high) {
+            state = STATE_HIGH;
+        } else if (value <= low) {
+            state = STATE_LOW;
+        }
+        if (state != STATE_UNKNOWN) {
+            initial_state = state;
+            defined_from = time;
+        }
+    } else if (state == STATE_LOW && value >= high) {
+        // last_value < high here, or the state would already be HIGH
+        double f = (high - last_value) / (value - last_value);
+        edge_times.push_back(last_time + (time - last_time) * f);
+        edge_rising.push_back(1);
+        state = STATE_HIGH;
+    } else if (state == STATE_HIGH && value <= low) {
+        double f = (last_value - low) / (last_value - value);
+        edge_times.push_back(last_time + (time - last_time) * f);
+        edge_rising.push_back(0);
+        state = STATE_LOW;
+    }
+
+    last_time = time;
+    last_value = value;
+}
+
+EdgeIndex::State EdgeIndex::state_at(double time) const {
+    if (initial_state == STATE_UNKNOWN || time < defined_from) {
+        return STATE_UNKNOWN;
+    }
+
+    // Last edge at or before 'time'
+    size_t count = std::upper_bound(edge_times.begin(), edge_times.end(), time) - edge_times.begin();
+    if (count == 0) {
+        return initial_state;
+    }
+    return edge_rising[count - 1] ? STATE_HIGH : STATE_LOW;
+}
+
+size_t EdgeIndex::count_edges(double t0, double t1) const {
+    if (t1 < t0) {
+        return 0;
+    }
+    std::vector<double>::const_iterator first = std::lower_bound(edge_times.begin(), edge_times.end(), t0);
+    std::vector<double>::const_iterator last = std::upper_bound(first, edge_times.end(), t1);
+    return last - first;
+}
+
+void EdgeIndex::get_edges(double t0, double t1, std::vector<double> &times, std::vector<uint8_t> &rising) const {
+    times.clear();
+    rising.clear();
+    if (t1 < t0) {
+        return;
+    }
+    size_t first = std::lower_bound(edge_times.begin(), edge_times.end(), t0) - edge_times.begin();
+    size_t last = std::upper_bound(edge_times.begin() + first, edge_times.end(), t1) - edge_times.begin();
+    times.assign(edge_times.begin() + first, edge_times.begin() + last);
+    rising.assign(edge_rising.begin() + first, edge_rising.begin() + last);
+}
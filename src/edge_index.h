@@ -0,0 +1,56 @@
+#ifndef EDGE_INDEX_H
+#define EDGE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Threshold crossings of one vector, built sample by sample. With
+// hysteresis, a LOW signal goes HIGH when it reaches 'high' and a HIGH one
+// goes LOW when it falls to 'low'; the edge time is interpolated linearly
+// at that threshold. Edges are kept sorted by time (the scale of a
+// transient only increases), so point and range queries are binary searches.
+class EdgeIndex {
+public:
+    enum State {
+        STATE_UNKNOWN = -1,
+        STATE_LOW = 0,
+        STATE_HIGH = 1,
+    };
+
+private:
+    double low;
+    double high;
+
+    // Logic state is undefined until the signal first leaves the band
+    State initial_state;
+    double defined_from;
+
+    State state;
+    double last_time;
+    double last_value;
+
+    std::vector<double> edge_times;
+    std::vector<uint8_t> edge_rising;
+
+public:
+    EdgeIndex();
+
+    void configure(double p_low, double p_high);
+    void reset();
+
+    double get_low() const { return low; }
+    double get_high() const { return high; }
+
+    void append(double time, double value);
+
+    size_t get_edge_count() const { return edge_times.size(); }
+    State get_current_state() const { return state; }
+    State state_at(double time) const;
+
+    // Edges with t0 <= time <= t1
+    size_t count_edges(double t0, double t1) const;
+    void get_edges(double t0, double t1, std::vector<double> &times, std::vector<uint8_t> &rising) const;
+};
+
+#endif // EDGE_INDEX_H
@@ -0,0 +1,373 @@
+#include "graph_layout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Reusable barrier for the worker threads of one layout run
+class Barrier {
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    int count;
+    int waiting;
+    uint64_t generation;
+
+public:
+    explicit Barrier(int p_count) : count(p_count), waiting(0), generation(0) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t arrived = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            condition.notify_all();
+            return;
+        }
+        condition.wait(lock, [&] { return generation != arrived; });
+    }
+};
+
+// Quadtree of vertex positions with the centre of mass of every cell
+class QuadTree {
+private:
+    // Coincident vertices stop splitting here and share a leaf
+    static const int MAX_DEPTH = 24;
+
+    struct Cell {
+        float x, y, half;  // Centre and half extent
+        float cx, cy;      // Centre of mass
+        float mass;
+        int32_t children;  // First of four consecutive cells, -1 for a leaf
+        int32_t body;      // Vertex of a single-body leaf, -1 otherwise
+    };
+
+    std::vector<Cell> cells;
+
+    int32_t add_cell(float x, float y, float half) {
+        Cell cell = { x, y, half, 0.0f, 0.0f, 0.0f, -1, -1 };
+        cells.push_back(cell);
+        return (int32_t)cells.size() - 1;
+    }
+
+    int32_t quadrant(const Cell &cell, float x, float y) const {
+        return cell.children + (x >= cell.x ? 1 : 0) + (y >= cell.y ? 2 : 0);
+    }
+
+    void insert(int32_t body, float x, float y) {
+        int32_t c = 0;
+        for (int depth = 0;; depth++) {
+            if (cells[c].children < 0) {
+                if (cells[c].mass == 0.0f) {
+                    cells[c].body = body;
+                    cells[c].cx = x;
+                    cells[c].cy = y;
+                    cells[c].mass = 1.0f;
+                    return;
+                }
+                if (depth >= MAX_DEPTH) {
+                    Cell &leaf = cells[c];
+                    leaf.cx = (leaf.cx * leaf.mass + x) / (leaf.mass + 1.0f);
+                    leaf.cy = (leaf.cy * leaf.mass + y) / (leaf.mass + 1.0f);
+                    leaf.mass += 1.0f;
+                    leaf.body = -1;
+                    return;
+                }
+
+                // Split the leaf and push its body one level down
+                float half = cells[c].half * 0.5f;
+                float cx = cells[c].x;
+                float cy = cells[c].y;
+                int32_t first = add_cell(cx - half, cy - half, half);
+                add_cell(cx + half, cy - half, half);
+                add_cell(cx - half, cy + half, half);
+                add_cell(cx + half, cy + half, half);
+
+                Cell &cell = cells[c];
+                cell.children = first;
+                Cell &child = cells[quadrant(cell, cell.cx, cell.cy)];
+                child.body = cell.body;
+                child.cx = cell.cx;
+                child.cy = cell.cy;
+                child.mass = 1.0f;
+                cell.body = -1;
+            }
+
+            Cell &cell = cells[c];
+            cell.cx = (cell.cx * cell.mass + x) / (cell.mass + 1.0f);
+            cell.cy = (cell.cy * cell.mass + y) / (cell.mass + 1.0f);
+            cell.mass += 1.0f;
+            c = quadrant(cell, x, y);
+        }
+    }
+
+public:
+    void build(const std::vector<float> &xs, const std::vector<float> &ys) {
+        cells.clear();
+        if (xs.empty()) {
+            return;
+        }
+
+        float min_x = xs[0], max_x = xs[0], min_y = ys[0], max_y = ys[0];
+        for (size_t i = 1; i < xs.size(); i++) {
+            min_x = std::min(min_x, xs[i]);
+            max_x = std::max(max_x, xs[i]);
+            min_y = std::min(min_y, ys[i]);
+            max_y = std::max(max_y, ys[i]);
+        }
+        float half = std::max(max_x - min_x, max_y - min_y) * 0.5f + 1e-3f;
+        add_cell((min_x + max_x) * 0.5f, (min_y + max_y) * 0.5f, half);
+
+        for (size_t i = 0; i < xs.size(); i++) {
+            insert((int32_t)i, xs[i], ys[i]);
+        }
+    }
+
+    // Sum of mass / d^2 * (dx, dy) over all other vertices
+    void repulsion(int32_t body, float x, float y, float theta2, float &fx, float &fy) const {
+        int32_t stack[4 * MAX_DEPTH + 8];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Cell &cell = cells[stack[--top]];
+            if (cell.mass == 0.0f || cell.body == body) {
+                continue;
+            }
+            float dx = x - cell.cx;
+            float dy = y - cell.cy;
+            float d2 = dx * dx + dy * dy;
+
+            if (cell.children >= 0 && 4.0f * cell.half * cell.half >= theta2 * d2) {
+                for (int k = 0; k < 4; k++) {
+                    stack[top++] = cell.children + k;
+                }
+                continue;
+            }
+            if (d2 < 1e-12f) {
+                continue;
+            }
+            float scale = cell.mass / d2;
+            fx += dx * scale;
+            fy += dy * scale;
+        }
+    }
+};
+
+} // namespace
+
+// Coarser copy of a graph made by merging matched neighbour pairs
+struct GraphLevel {
+    size_t vertex_count;
+    std::vector<int32_t> offsets;
+    std::vector<int32_t> targets;
+    std::vector<int32_t> parent;  // Vertex of the next coarser level
+};
+
+static bool coarsen(GraphLevel &fine, GraphLevel &coarse) {
+    const size_t n = fine.vertex_count;
+    std::vector<int32_t> &parent = fine.parent;
+    parent.assign(n, -1);
+
+    // Greedy matching, preferring the neighbour with the fewest edges so
+    // hubs (supply rails) don't swallow everything around them
+    int32_t count = 0;
+    for (size_t v = 0; v < n; v++) {
+        if (parent[v] >= 0) {
+            continue;
+        }
+        int32_t best = -1;
+        int32_t best_degree = 0;
+        for (int32_t e = fine.offsets[v]; e < fine.offsets[v + 1]; e++) {
+            int32_t w = fine.targets[e];
+            int32_t degree = fine.offsets[w + 1] - fine.offsets[w];
+            if (w != (int32_t)v && parent[w] < 0 && (best < 0 || degree < best_degree)) {
+                best = w;
+                best_degree = degree;
+            }
+        }
+        parent[v] = count;
+        if (best >= 0) {
+            parent[best] = count;
+        }
+        count++;
+    }
+
+    // Not worth another level
+    if ((size_t)count > n * 3 / 4) {
+        return false;
+    }
+
+    std::vector<std::vector<int32_t>> members(count);
+    for (size_t v = 0; v < n; v++) {
+        members[parent[v]].push_back((int32_t)v);
+    }
+
+    coarse.vertex_count = count;
+    coarse.offsets.assign(1, 0);
+    coarse.targets.clear();
+    std::vector<int32_t> seen(count, -1);
+    for (int32_t c = 0; c < count; c++) {
+        for (int32_t v : members[c]) {
+            for (int32_t e = fine.offsets[v]; e < fine.offsets[v + 1]; e++) {
+                int32_t target = parent[fine.targets[e]];
+                if (target != c && seen[target] != c) {
+                    seen[target] = c;
+                    coarse.targets.push_back(target);
+                }
+            }
+        }
+        coarse.offsets.push_back((int32_t)coarse.targets.size());
+    }
+    return true;
+}
+
+// Force iterations on one level, starting from the given positions
+static void relax(const GraphLevel &level, const GraphLayout::Settings &settings,
+        int iterations, float temperature, int thread_count,
+        std::vector<float> &xs, std::vector<float> &ys) {
+    const size_t vertex_count = level.vertex_count;
+    const std::vector<int32_t> &offsets = level.offsets;
+    const std::vector<int32_t> &targets = level.targets;
+
+    const float k = settings.spacing;
+    const float k2 = k * k;
+    const float theta2 = settings.theta * settings.theta;
+
+    thread_count = std::max(1, std::min(thread_count, (int)(vertex_count / 256) + 1));
+
+    std::vector<float> next_x(vertex_count);
+    std::vector<float> next_y(vertex_count);
+    QuadTree tree;
+    tree.build(xs, ys);
+
+    // Linear cooling of the maximum step
+    const float cooling = temperature / (float)std::max(1, iterations);
+
+    Barrier barrier(thread_count);
+
+    auto worker = [&](int index) {
+        size_t begin = vertex_count * index / thread_count;
+        size_t end = vertex_count * (index + 1) / thread_count;
+
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            for (size_t v = begin; v < end; v++) {
+                float x = xs[v];
+                float y = ys[v];
+
+                float fx = 0.0f, fy = 0.0f;
+                tree.repulsion((int32_t)v, x, y, theta2, fx, fy);
+                fx *= k2;
+                fy *= k2;
+
+                for (int32_t e = offsets[v]; e < offsets[v + 1]; e++) {
+                    float dx = xs[targets[e]] - x;
+                    float dy = ys[targets[e]] - y;
+                    float d = std::sqrt(dx * dx + dy * dy);
+                    fx += dx * d / k;
+                    fy += dy * d / k;
+                }
+
+                fx -= settings.gravity * x;
+                fy -= settings.gravity * y;
+
+                float length = std::sqrt(fx * fx + fy * fy);
+                float step = length > temperature ? temperature / length : 1.0f;
+                next_x[v] = x + fx * step;
+                next_y[v] = y + fy * step;
+            }
+
+            barrier.wait();
+            if (index == 0) {
+                xs.swap(next_x);
+                ys.swap(next_y);
+                temperature = std::max(temperature - cooling, k * 0.01f);
+                if (iteration + 1 < iterations) {
+                    tree.build(xs, ys);
+                }
+            }
+            barrier.wait();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_count; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+void GraphLayout::run(size_t vertex_count, const std::vector<int32_t> &offsets,
+        const std::vector<int32_t> &targets, const Settings &settings,
+        std::vector<float> &xs, std::vector<float> &ys) {
+    xs.assign(vertex_count, 0.0f);
+    ys.assign(vertex_count, 0.0f);
+    if (vertex_count == 0) {
+        return;
+    }
+
+    int thread_count = settings.threads > 0 ? settings.threads : (int)std::thread::hardware_concurrency();
+    const float k = settings.spacing;
+
+    // Multilevel: lay out a coarsened graph first, then refine each finer
+    // level from its parent's positions. Fine levels start close to their
+    // final shape and only need a few iterations.
+    std::vector<GraphLevel> levels(1);
+    levels[0].vertex_count = vertex_count;
+    levels[0].offsets = offsets;
+    levels[0].targets = targets;
+    while (levels.back().vertex_count > 64) {
+        GraphLevel coarse;
+        if (!coarsen(levels.back(), coarse)) {
+            break;
+        }
+        levels.push_back(std::move(coarse));
+    }
+
+    // Deterministic random start for the coarsest level
+    const GraphLevel &coarsest = levels.back();
+    std::vector<float> level_x(coarsest.vertex_count);
+    std::vector<float> level_y(coarsest.vertex_count);
+    float extent = std::sqrt((float)coarsest.vertex_count) * k;
+    uint32_t state = settings.seed ? settings.seed : 1;
+    auto random = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state & 0xffff) / 65535.0f - 0.5f;
+    };
+    for (size_t i = 0; i < coarsest.vertex_count; i++) {
+        level_x[i] = random() * extent;
+        level_y[i] = random() * extent;
+    }
+    relax(coarsest, settings, settings.iterations, extent * 0.1f, thread_count, level_x, level_y);
+
+    const int refine_iterations = std::max(10, settings.iterations / 6);
+    for (size_t l = levels.size() - 1; l > 0; l--) {
+        const GraphLevel &fine = levels[l - 1];
+        const GraphLevel &coarse = levels[l];
+
+        // Spread clusters apart as the vertex count grows, then split each
+        // cluster with a small jitter
+        float scale = std::sqrt((float)fine.vertex_count / (float)coarse.vertex_count);
+        std::vector<float> fine_x(fine.vertex_count);
+        std::vector<float> fine_y(fine.vertex_count);
+        for (size_t v = 0; v < fine.vertex_count; v++) {
+            fine_x[v] = level_x[fine.parent[v]] * scale + random() * k * 0.2f;
+            fine_y[v] = level_y[fine.parent[v]] * scale + random() * k * 0.2f;
+        }
+        level_x.swap(fine_x);
+        level_y.swap(fine_y);
+        relax(fine, settings, refine_iterations, k, thread_count, level_x, level_y);
+    }
+
+    xs.swap(level_x);
+    ys.swap(level_y);
+}
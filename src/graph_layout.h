@@ -0,0 +1,30 @@
+#ifndef GRAPH_LAYOUT_H
+#define GRAPH_LAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Force-directed (Fruchterman-Reingold) layout. Repulsion uses a Barnes-Hut
+// quadtree, so one iteration is O(V log V + E) instead of O(V^2). Forces are
+// computed from the previous positions only, so vertex ranges are split
+// across threads and the result does not depend on the thread count.
+class GraphLayout {
+public:
+    struct Settings {
+        int iterations = 100;
+        float spacing = 1.0f;   // Ideal edge length
+        float theta = 1.0f;     // Barnes-Hut opening angle
+        float gravity = 0.05f;  // Pull towards the origin, keeps components together
+        int threads = 0;        // 0 = hardware concurrency
+        uint32_t seed = 1;
+    };
+
+    // Adjacency in CSR form: neighbours of v are targets[offsets[v] .. offsets[v + 1]).
+    // Edges must be listed in both directions.
+    static void run(size_t vertex_count, const std::vector<int32_t> &offsets,
+        const std::vector<int32_t> &targets, const Settings &settings,
+        std::vector<float> &xs, std::vector<float> &ys);
+};
+
+#endif // GRAPH_LAYOUT_H
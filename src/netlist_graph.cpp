@@ -0,0 +1,218 @@
+#include "netlist_graph.h"
+
+#include <cctype>
+
+// Fixed pin counts by element letter; 0 = variable (X, N, A), -1 = no pins
+static int pin_count(char type) {
+    switch (type) {
+        case 'r': case 'c': case 'l': case 'v': case 'i':
+        case 'd': case 'b': case 'f': case 'h': case 'w':
+            return 2;
+        case 'q': case 'j': case 'z': case 'u':
+            return 3;
+        case 'm': case 'e': case 'g': case 's': case 't': case 'o':
+            return 4;
+        case 'x': case 'n': case 'a':
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+// Start of the value/parameter part of an element line. Stops the pin list
+// early, e.g. "E1 out 0 value={v(a)*2}" or "G1 a b poly(1) c d 0 1" only
+// connect their two output nodes.
+static bool is_parameter_token(const std::string &token) {
+    return token.find_first_of("={(") != std::string::npos || token == "value" || token == "poly" ||
+        token == "table" || token == "laplace" || token == "vol" || token == "cur";
+}
+
+static std::vector<std::string> tokenize(const std::string &line) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && isspace((unsigned char)line[i])) {
+            i++;
+        }
+        size_t start = i;
+        while (i < line.size() && !isspace((unsigned char)line[i])) {
+            i++;
+        }
+        if (i > start) {
+            tokens.push_back(line.substr(start, i - start));
+        }
+    }
+    return tokens;
+}
+
+// Lowercase and drop inline comments (';' anywhere, '$' after whitespace)
+static std::string clean_line(const char *line) {
+    std::string result;
+    for (size_t i = 0; line[i] != '\0'; i++) {
+        char c = line[i];
+        if (c == ';' || (c == '$' && (i == 0 || isspace((unsigned char)line[i - 1])))) {
+            break;
+        }
+        result += (char)tolower((unsigned char)c);
+    }
+    return result;
+}
+
+NetlistGraph::NetlistGraph() {
+    ground = -1;
+}
+
+void NetlistGraph::clear() {
+    node_names.clear();
+    element_names.clear();
+    element_types.clear();
+    element_offsets.assign(1, 0);
+    element_pins.clear();
+    node_offsets.assign(1, 0);
+    node_elements.clear();
+    ground = -1;
+}
+
+int32_t NetlistGraph::intern_node(const std::string &name, std::unordered_map<std::string, int32_t> &lookup) {
+    // "gnd" is an alias of node 0 in ngspice
+    const std::string &key = (name == "gnd") ? std::string("0") : name;
+    auto found = lookup.find(key);
+    if (found != lookup.end()) {
+        return found->second;
+    }
+    int32_t index = (int32_t)node_names.size();
+    node_names.push_back(key);
+    lookup.emplace(key, index);
+    if (key == "0") {
+        ground = index;
+    }
+    return index;
+}
+
+void NetlistGraph::add_element(const std::vector<std::string> &tokens, std::unordered_map<std::string, int32_t> &lookup) {
+    char type = tokens[0][0];
+    int pins = pin_count(type);
+    if (pins < 0) {
+        return;
+    }
+
+    std::vector<std::string> nodes;
+    if (pins > 0) {
+        for (int i = 1; i <= pins && i < (int)tokens.size() && !is_parameter_token(tokens[i]); i++) {
+            nodes.push_back(tokens[i]);
+        }
+    } else if (type == 'a') {
+        // XSPICE: port lists may be bracketed and carry %-modifiers; the last
+        // token is the model name
+        for (size_t i = 1; i + 1 < tokens.size(); i++) {
+            std::string token = tokens[i];
+            if (token[0] == '%') {
+                continue;
+            }
+            std::string name;
+            for (char c : token) {
+                if (c != '[' && c != ']' && c != '~') {
+                    name += c;
+                }
+            }
+            if (!name.empty() && name != "null") {
+                nodes.push_back(name);
+            }
+        }
+    } else {
+        // Subcircuit / OSDI instance: nodes, then the subckt or model name,
+        // then optional parameters
+        size_t end = tokens.size();
+        for (size_t i = 1; i < tokens.size(); i++) {
+            if (tokens[i] == "params:" || tokens[i].find('=') != std::string::npos) {
+                end = i;
+                break;
+            }
+        }
+        for (size_t i = 1; i + 1 < end; i++) {
+            nodes.push_back(tokens[i]);
+        }
+    }
+
+    element_names.push_back(tokens[0]);
+    element_types.push_back(type);
+    for (const std::string &node : nodes) {
+        element_pins.push_back(intern_node(node, lookup));
+    }
+    element_offsets.push_back((int32_t)element_pins.size());
+}
+
+void NetlistGraph::build_node_index() {
+    // Counting sort of the element pins by node
+    size_t node_count = node_names.size();
+    node_offsets.assign(node_count + 1, 0);
+    for (int32_t node : element_pins) {
+        node_offsets[node + 1]++;
+    }
+    for (size_t n = 0; n < node_count; n++) {
+        node_offsets[n + 1] += node_offsets[n];
+    }
+
+    node_elements.resize(element_pins.size());
+    std::vector<int32_t> fill(node_offsets.begin(), node_offsets.end() - 1);
+    for (size_t e = 0; e < element_names.size(); e++) {
+        for (int32_t p = element_offsets[e]; p < element_offsets[e + 1]; p++) {
+            node_elements[fill[element_pins[p]]++] = (int32_t)e;
+        }
+    }
+}
+
+void NetlistGraph::parse(const char *const *lines, size_t count) {
+    clear();
+
+    // Join '+' continuation lines first
+    std::vector<std::string> cards;
+    for (size_t i = 1; i < count; i++) {
+        std::string line = clean_line(lines[i]);
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '*') {
+            continue;
+        }
+        if (line[first] == '+') {
+            if (!cards.empty()) {
+                cards.back() += " " + line.substr(first + 1);
+            }
+            continue;
+        }
+        cards.push_back(line.substr(first));
+    }
+
+    std::unordered_map<std::string, int32_t> lookup;
+    int subckt_depth = 0;
+    bool in_control = false;
+
+    for (const std::string &card : cards) {
+        std::vector<std::string> tokens = tokenize(card);
+        if (tokens.empty()) {
+            continue;
+        }
+        const std::string &head = tokens[0];
+
+        if (in_control) {
+            in_control = (head != ".endc");
+            continue;
+        }
+        if (head[0] == '.') {
+            if (head == ".subckt") {
+                subckt_depth++;
+            } else if (head == ".ends") {
+                subckt_depth = subckt_depth > 0 ? subckt_depth - 1 : 0;
+            } else if (head == ".control") {
+                in_control = true;
+            } else if (head == ".end") {
+                break;
+            }
+            continue;
+        }
+        if (subckt_depth == 0) {
+            add_element(tokens, lookup);
+        }
+    }
+
+    build_node_index();
+}
@@ -0,0 +1,57 @@
+#ifndef NETLIST_GRAPH_H
+#define NETLIST_GRAPH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Circuit topology extracted from a SPICE netlist, stored as two CSR
+// (compressed sparse row) adjacency lists: element -> pin nodes and
+// node -> connected elements. Element lines inside .subckt definitions are
+// skipped (only their X instances are part of the top-level circuit), as
+// are control sections, .include files and K coupling cards.
+class NetlistGraph {
+private:
+    std::vector<std::string> node_names;
+    std::vector<std::string> element_names;
+    std::vector<char> element_types;
+
+    std::vector<int32_t> element_offsets;
+    std::vector<int32_t> element_pins;
+    std::vector<int32_t> node_offsets;
+    std::vector<int32_t> node_elements;
+
+    int32_t ground;
+
+    int32_t intern_node(const std::string &name, std::unordered_map<std::string, int32_t> &lookup);
+    void add_element(const std::vector<std::string> &tokens, std::unordered_map<std::string, int32_t> &lookup);
+    void build_node_index();
+
+public:
+    NetlistGraph();
+
+    void clear();
+
+    // First line is the title, as in any SPICE deck
+    void parse(const char *const *lines, size_t count);
+
+    size_t get_node_count() const { return node_names.size(); }
+    size_t get_element_count() const { return element_names.size(); }
+    int32_t get_ground() const { return ground; }
+
+    const std::vector<std::string> &get_node_names() const { return node_names; }
+    const std::vector<std::string> &get_element_names() const { return element_names; }
+    const std::vector<char> &get_element_types() const { return element_types; }
+
+    // Pins of element e: element_pins[element_offsets[e] .. element_offsets[e + 1])
+    const std::vector<int32_t> &get_element_offsets() const { return element_offsets; }
+    const std::vector<int32_t> &get_element_pins() const { return element_pins; }
+
+    // Elements on node n: node_elements[node_offsets[n] .. node_offsets[n + 1])
+    const std::vector<int32_t> &get_node_offsets() const { return node_offsets; }
+    const std::vector<int32_t> &get_node_elements() const { return node_elements; }
+};
+
+#endif // NETLIST_GRAPH_H
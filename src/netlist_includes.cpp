@@ -0,0 +1,40 @@
+#include "netlist_includes.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+bool resolve_include_line(const char *line, const std::string &base_dir, std::string &resolved) {
+    if (base_dir.empty()) {
+        return false;
+    }
+
+    const char *directive = line + strspn(line, " \t");
+    size_t directive_length = strcspn(directive, " \t");
+    std::string name(directive, directive_length);
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)tolower(c); });
+    if (name != ".include" && name != ".inc" && name != ".lib") {
+        return false;
+    }
+
+    // .lib with a single argument opens a section inside a library file
+    const char *path = directive + directive_length;
+    path += strspn(path, " \t");
+    bool quoted = *path == '"';
+    if (quoted) {
+        path++;
+    }
+    size_t path_length = quoted ? strcspn(path, "\"") : strcspn(path, " \t");
+    const char *rest = path + path_length + (quoted && path[path_length] == '"' ? 1 : 0);
+    bool has_section = rest[strspn(rest, " \t")] != '\0';
+    if (path_length == 0 || (name == ".lib" && !has_section)) {
+        return false;
+    }
+    if (path[0] == '/' || path[0] == '\\' || path[0] == '~' || (path_length > 1 && path[1] == ':')) {
+        return false;
+    }
+
+    resolved.assign(directive, directive_length);
+    resolved += " \"" + base_dir + "/" + std::string(path, path_length) + "\"" + rest;
+    return true;
+}
@@ -0,0 +1,12 @@
+#ifndef NETLIST_INCLUDES_H
+#define NETLIST_INCLUDES_H
+
+#include <string>
+
+// Makes the path of a relative .include / .inc / .lib card absolute against
+// 'base_dir' (the netlist's directory), so ngspice finds the file no matter
+// what its working directory is. Returns false and leaves 'resolved' alone
+// for other lines, absolute paths and .lib section markers.
+bool resolve_include_line(const char *line, const std::string &base_dir, std::string &resolved);
+
+#endif // NETLIST_INCLUDES_H
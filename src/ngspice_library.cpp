@@ -0,0 +1,258 @@
+#include "ngspice_library.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Copies the library to a file nobody else can have created or replaced:
+// a fresh file from GetTempFileName in the per-user temp directory on
+// Windows, and an O_EXCL file inside a new 0700 directory elsewhere.
+// 'directory' is set when one was created.
+static bool copy_library(const std::string &from, std::string &to, std::string &directory) {
+#ifdef _WIN32
+    char temp_dir[MAX_PATH];
+    char temp_file[MAX_PATH];
+    DWORD length = GetTempPathA(MAX_PATH, temp_dir);
+    if (length == 0 || length >= MAX_PATH || GetTempFileNameA(temp_dir, "ngs", 0, temp_file) == 0) {
+        return false;
+    }
+    to = temp_file;
+    if (CopyFileA(from.c_str(), to.c_str(), FALSE) == 0) {
+        DeleteFileA(to.c_str());
+        return false;
+    }
+    return true;
+#else
+    const char *temp_dir = getenv("TMPDIR");
+    std::string pattern = std::string((temp_dir && *temp_dir) ? temp_dir : "/tmp") + "/ngspice_XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    if (!mkdtemp(name.data())) {
+        return false;
+    }
+    directory = name.data();
+    size_t dot = from.find_last_of('.');
+    size_t slash = from.find_last_of('/');
+    bool has_extension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    to = directory + "/libngspice" + (has_extension ? from.substr(dot) : std::string());
+
+    int in = open(from.c_str(), O_RDONLY);
+    int out = open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0700);
+    bool ok = in >= 0 && out >= 0;
+    char buffer[65536];
+    while (ok) {
+        ssize_t count = read(in, buffer, sizeof(buffer));
+        if (count <= 0) {
+            ok = count == 0;
+            break;
+        }
+        for (ssize_t written = 0; ok && written < count;) {
+            ssize_t n = write(out, buffer + written, count - written);
+            ok = n > 0;
+            written += n;
+        }
+    }
+    if (in >= 0) {
+        close(in);
+    }
+    if (out >= 0) {
+        ok = (close(out) == 0) && ok;
+    }
+    if (!ok) {
+        unlink(to.c_str());
+        rmdir(directory.c_str());
+        directory.clear();
+    }
+    return ok;
+#endif
+}
+
+NgspiceLibrary::NgspiceLibrary() {
+    handle = nullptr;
+    init = nullptr;
+    init_sync = nullptr;
+    command = nullptr;
+    get_vec_info = nullptr;
+    cur_plot = nullptr;
+    all_plots = nullptr;
+    all_vecs = nullptr;
+    circ = nullptr;
+    running = nullptr;
+    nospinit = nullptr;
+}
+
+std::vector<std::string> NgspiceLibrary::default_paths() {
+#ifdef _WIN32
+    // Try loading from bin folder as well
+    return { "ngspice.dll", "bin/ngspice.dll" };
+#else
+    return { "libngspice.so", "./libngspice.so" };
+#endif
+}
+
+bool NgspiceLibrary::load(const std::vector<std::string> &paths, std::string &error) {
+    unload();
+
+    for (const std::string &path : paths) {
+#ifdef _WIN32
+        handle = LoadLibraryA(path.c_str());
+        if (handle) {
+            break;
+        }
+        error = "Failed to load " + path;
+#else
+        handle = dlopen(path.c_str(), RTLD_NOW);
+        if (handle) {
+            break;
+        }
+        const char* reason = dlerror();
+        error = "Failed to load " + path + ": " + (reason ? reason : "unknown error");
+#endif
+    }
+
+    if (!handle) {
+        return false;
+    }
+
+#ifdef _WIN32
+#define NG_SYMBOL(name) GetProcAddress(handle, name)
+#else
+#define NG_SYMBOL(name) dlsym(handle, name)
+#endif
+
+    init = (int (*)(SendChar*, SendStat*, ControlledExit*, SendData*, SendInitData*, BGThreadRunning*, void*))
+        NG_SYMBOL("ngSpice_Init");
+    init_sync = (int (*)(GetVSRCData*, GetISRCData*, GetSyncData*, int*, void*))
+        NG_SYMBOL("ngSpice_Init_Sync");
+    command = (int (*)(char*))
+        NG_SYMBOL("ngSpice_Command");
+    get_vec_info = (pvector_info (*)(char*))
+        NG_SYMBOL("ngGet_Vec_Info");
+    cur_plot = (char* (*)())
+        NG_SYMBOL("ngSpice_CurPlot");
+    all_plots = (char** (*)())
+        NG_SYMBOL("ngSpice_AllPlots");
+    all_vecs = (char** (*)(char*))
+        NG_SYMBOL("ngSpice_AllVecs");
+    circ = (int (*)(char**))
+        NG_SYMBOL("ngSpice_Circ");
+    running = (bool (*)())
+        NG_SYMBOL("ngSpice_running");
+    nospinit = (int (*)())
+        NG_SYMBOL("ngSpice_nospinit");
+
+#undef NG_SYMBOL
+
+    if (!init || !command) {
+        error = "Failed to load required ngspice functions";
+        unload();
+        return false;
+    }
+
+    return true;
+}
+
+bool NgspiceLibrary::load_copy(const std::vector<std::string> &paths, std::string &error) {
+    // Load in place first to find the file through the usual search paths
+    if (!load(paths, error)) {
+        return false;
+    }
+    std::string module_path = get_module_path();
+    if (module_path.empty()) {
+        error = "Cannot locate the loaded ngspice library";
+        unload();
+        return false;
+    }
+
+    // Keep the shared module loaded until the copy is, so the copy resolves
+    // its dependencies against the modules already in memory
+    NgspiceLibrary shared = *this;
+    handle = nullptr;
+
+    std::string path;
+    std::string directory;
+    bool loaded = false;
+    if (copy_library(module_path, path, directory)) {
+        loaded = load({ path }, error);
+#ifdef _WIN32
+        // A loaded DLL cannot be deleted; unload() removes it
+        if (loaded) {
+            copy_path = path;
+        } else {
+            DeleteFileA(path.c_str());
+        }
+#else
+        // The mapping stays valid without the file, so nothing is left
+        // behind even if the process crashes
+        unlink(path.c_str());
+        rmdir(directory.c_str());
+#endif
+    } else {
+        error = "Failed to copy " + module_path + " to the temp directory";
+    }
+    shared.unload();
+    return loaded;
+}
+
+std::string NgspiceLibrary::get_module_path() const {
+    if (!handle) {
+        return std::string();
+    }
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD length = GetModuleFileNameA(handle, path, MAX_PATH);
+    return (length > 0 && length < MAX_PATH) ? std::string(path, length) : std::string();
+#else
+    Dl_info info;
+    if (!init || !dladdr((void*)init, &info) || !info.dli_fname) {
+        return std::string();
+    }
+    return info.dli_fname;
+#endif
+}
+
+void NgspiceLibrary::unload() {
+    if (handle) {
+#ifdef _WIN32
+        FreeLibrary(handle);
+#else
+        dlclose(handle);
+#endif
+        handle = nullptr;
+    }
+
+    if (!copy_path.empty()) {
+        remove(copy_path.c_str());
+        copy_path.clear();
+    }
+
+    init = nullptr;
+    init_sync = nullptr;
+    command = nullptr;
+    get_vec_info = nullptr;
+    cur_plot = nullptr;
+    all_plots = nullptr;
+    all_vecs = nullptr;
+    circ = nullptr;
+    running = nullptr;
+    nospinit = nullptr;
+}
+
+bool NgspiceLibrary::is_loaded() const {
+    return handle != nullptr;
+}
+
+bool NgspiceLibrary::find_real_vector(const char *name, const double *&data, size_t &length) const {
+    pvector_info vec = get_vec_info ? get_vec_info((char*)name) : nullptr;
+    if (!vec || !vec->v_realdata) {
+        return false;
+    }
+    data = vec->v_realdata;
+    length = (size_t)vec->v_length;
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef NGSPICE_LIBRARY_H
+#define NGSPICE_LIBRARY_H
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include <string>
+#include <vector>
+
+#include "sharedspice.h"
+
+// Dynamically loaded ngspice shared library and its entry points.
+// Does not depend on Godot, so it is shared by the extension and the
+// out-of-process simulation worker.
+struct NgspiceLibrary {
+#ifdef _WIN32
+    HMODULE handle;
+#else
+    void* handle;
+#endif
+
+    // Private copy of the library file, deleted on unload. Only kept on
+    // Windows, where a loaded DLL cannot be deleted; elsewhere the copy is
+    // unlinked as soon as it is loaded.
+    std::string copy_path;
+
+    // Function pointers for ngspice API
+    int (*init)(SendChar*, SendStat*, ControlledExit*, SendData*, SendInitData*, BGThreadRunning*, void*);
+    int (*init_sync)(GetVSRCData*, GetISRCData*, GetSyncData*, int*, void*);
+    int (*command)(char*);
+    pvector_info (*get_vec_info)(char*);
+    char* (*cur_plot)();
+    char** (*all_plots)();
+    char** (*all_vecs)(char*);
+    int (*circ)(char**);
+    bool (*running)();
+    int (*nospinit)();
+
+    NgspiceLibrary();
+
+    // Tries each path in order; on failure 'error' describes the last attempt
+    bool load(const std::vector<std::string> &paths, std::string &error);
+
+    // Loads a private copy of the library, so this instance has its own
+    // globals (circuits, plots, background thread) even when others are
+    // loaded in the same process. The copy goes to a private file in the
+    // temp directory.
+    bool load_copy(const std::vector<std::string> &paths, std::string &error);
+
+    void unload();
+    bool is_loaded() const;
+
+    // Real data of a vector in the current plot. ngGet_Vec_Info fills one
+    // static struct on every call, so the pointer and length are copied out
+    // before the next lookup overwrites them.
+    bool find_real_vector(const char *name, const double *&data, size_t &length) const;
+
+    // File the loaded library was mapped from
+    std::string get_module_path() const;
+
+    // Platform default locations of the library
+    static std::vector<std::string> default_paths();
+};
+
+#endif // NGSPICE_LIBRARY_H
@@ -1,6 +1,11 @@
 #include "register_types.h"
 
 #include "circuit_sim.h"
+#include "current_flow.h"
+#include "sim_snapshot.h"
+#include "sim_vector.h"
+#include "sim_worker_pool.h"
+#include "sweep_tensor.h"
 
 #include <gdextension_interface.h>
 #include <godot_cpp/core/defs.hpp>
@@ -14,6 +19,11 @@ void initialize_circuit_sim_module(ModuleInitializationLevel p_level) {
     }
 
     ClassDB::register_class<CircuitSimulator>();
+    ClassDB::register_class<SimVector>();
+    ClassDB::register_class<SimWorkerPool>();
+    ClassDB::register_class<SweepTensor>();
+    ClassDB::register_class<CurrentFlow>();
+    ClassDB::register_class<SimSnapshot>();
 }
 
 void uninitialize_circuit_sim_module(ModuleInitializationLevel p_level) {
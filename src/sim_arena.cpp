@@ -0,0 +1,80 @@
+#include "sim_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+SimArena::SimArena(size_t p_chunk_size) {
+    current = 0;
+    chunk_size = p_chunk_size;
+    memset(&stats, 0, sizeof(stats));
+}
+
+SimArena::~SimArena() {
+    release();
+}
+
+void *SimArena::allocate(size_t size, size_t align) {
+    // Current chunk first, then any later (rewound) chunk that fits
+    for (; current < chunks.size(); current++) {
+        Chunk &chunk = chunks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data);
+        size_t offset = ((base + chunk.used + align - 1) & ~(uintptr_t)(align - 1)) - base;
+        if (offset + size <= chunk.size) {
+            chunk.used = offset + size;
+            stats.allocations++;
+            stats.bytes_used += size;
+            return chunk.data + offset;
+        }
+    }
+
+    // Oversized requests get a chunk of their own
+    size_t bytes = size + align > chunk_size ? size + align : chunk_size;
+    Chunk chunk;
+    chunk.data = static_cast<unsigned char *>(malloc(bytes));
+    if (!chunk.data) {
+        return nullptr;
+    }
+    chunk.size = bytes;
+    chunk.used = 0;
+    chunks.push_back(chunk);
+    current = chunks.size() - 1;
+    stats.heap_allocations++;
+    stats.bytes_reserved += bytes;
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(chunk.data);
+    size_t offset = ((base + align - 1) & ~(uintptr_t)(align - 1)) - base;
+    chunks[current].used = offset + size;
+    stats.allocations++;
+    stats.bytes_used += size;
+    return chunk.data + offset;
+}
+
+char *SimArena::copy_string(const char *text, size_t length) {
+    char *copy = static_cast<char *>(allocate(length + 1, 1));
+    if (copy) {
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+void SimArena::reset() {
+    for (Chunk &chunk : chunks) {
+        chunk.used = 0;
+    }
+    current = 0;
+    stats.allocations = 0;
+    stats.bytes_used = 0;
+    stats.resets++;
+}
+
+void SimArena::release() {
+    for (Chunk &chunk : chunks) {
+        free(chunk.data);
+    }
+    chunks.clear();
+    current = 0;
+    stats.allocations = 0;
+    stats.bytes_used = 0;
+    stats.bytes_reserved = 0;
+}
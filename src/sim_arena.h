@@ -0,0 +1,57 @@
+#ifndef SIM_ARENA_H
+#define SIM_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bump allocator over a list of chunks. reset() rewinds every chunk but
+// keeps it, so a run that fits in what earlier runs used takes no new
+// chunks. Individual allocations are never freed. The stats cover the
+// arena only, not other allocations made next to it.
+class SimArena {
+public:
+    struct Stats {
+        uint64_t heap_allocations;  // Chunks taken from the heap, ever
+        uint64_t allocations;       // Allocations served since the last reset
+        uint64_t resets;
+        size_t bytes_used;
+        size_t bytes_reserved;
+    };
+
+private:
+    struct Chunk {
+        unsigned char *data;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t current;
+    size_t chunk_size;
+    Stats stats;
+
+public:
+    explicit SimArena(size_t p_chunk_size = 64 * 1024);
+    ~SimArena();
+
+    SimArena(const SimArena &) = delete;
+    SimArena &operator=(const SimArena &) = delete;
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template <typename T>
+    T *allocate_array(size_t count) {
+        return static_cast<T *>(allocate(sizeof(T) * (count ? count : 1), alignof(T)));
+    }
+
+    // Null-terminated copy of 'length' bytes
+    char *copy_string(const char *text, size_t length);
+
+    void reset();
+    void release();
+
+    const Stats &get_stats() const { return stats; }
+};
+
+#endif // SIM_ARENA_H
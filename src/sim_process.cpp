@@ -0,0 +1,579 @@
+#include "sim_process.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Unique shared-memory names within this process
+static std::atomic<int> shm_counter(0);
+
+static std::string make_shm_name() {
+    char name[64];
+#ifdef _WIN32
+    snprintf(name, sizeof(name), "Local\\circuit_sim_%lu_%d", (unsigned long)GetCurrentProcessId(), shm_counter++);
+#else
+    snprintf(name, sizeof(name), "/circuit_sim_%ld_%d", (long)getpid(), shm_counter++);
+#endif
+    return name;
+}
+
+SimWorkerProcess::SimWorkerProcess() {
+    eof = false;
+#ifdef _WIN32
+    process = nullptr;
+    stdin_write = nullptr;
+    stdout_read = nullptr;
+#else
+    pid = -1;
+    channel = -1;
+#endif
+}
+
+SimWorkerProcess::~SimWorkerProcess() {
+    kill();
+}
+
+bool SimWorkerProcess::start(const std::string &executable, const std::string &library, uint64_t ring_capacity,
+        std::string &error) {
+    kill();
+
+    if (!shm.create(make_shm_name(), SimRing::bytes_for(ring_capacity), error)) {
+        return false;
+    }
+    ring.create(shm.get_memory(), ring_capacity);
+
+#ifdef _WIN32
+    SECURITY_ATTRIBUTES sa;
+    sa.nLength = sizeof(sa);
+    sa.lpSecurityDescriptor = nullptr;
+    sa.bInheritHandle = TRUE;
+
+    HANDLE stdin_read = nullptr;
+    HANDLE stdout_write = nullptr;
+    if (!CreatePipe(&stdin_read, &stdin_write, &sa, 0) || !CreatePipe(&stdout_read, &stdout_write, &sa, 0)) {
+        error = "CreatePipe failed";
+        kill();
+        return false;
+    }
+    // Only the child's ends are inherited
+    SetHandleInformation(stdin_write, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(stdout_read, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOA si;
+    ZeroMemory(&si, sizeof(si));
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = stdin_read;
+    si.hStdOutput = stdout_write;
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+    PROCESS_INFORMATION pi;
+    std::string cmdline = "\"" + executable + "\" " + shm.get_name();
+    if (!library.empty()) {
+        cmdline += " \"" + library + "\"";
+    }
+
+    BOOL created = CreateProcessA(nullptr, &cmdline[0], nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+        nullptr, nullptr, &si, &pi);
+    CloseHandle(stdin_read);
+    CloseHandle(stdout_write);
+    if (!created) {
+        error = "Failed to start worker: " + executable;
+        kill();
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    process = pi.hProcess;
+#else
+    int fds[2];
+    int type = SOCK_STREAM;
+#ifdef SOCK_CLOEXEC
+    // Keep this channel out of workers started later
+    type |= SOCK_CLOEXEC;
+#endif
+    if (socketpair(AF_UNIX, type, 0, fds) != 0) {
+        error = std::string("socketpair failed: ") + strerror(errno);
+        kill();
+        return false;
+    }
+
+    // Build argv before fork; only async-signal-safe calls in the child
+    std::string shm_name = shm.get_name();
+    std::vector<char*> argv;
+    argv.push_back((char*)executable.c_str());
+    argv.push_back((char*)shm_name.c_str());
+    if (!library.empty()) {
+        argv.push_back((char*)library.c_str());
+    }
+    argv.push_back(nullptr);
+
+    pid = fork();
+    if (pid < 0) {
+        error = std::string("fork failed: ") + strerror(errno);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        kill();
+        return false;
+    }
+    if (pid == 0) {
+        dup2(fds[1], STDIN_FILENO);
+        dup2(fds[1], STDOUT_FILENO);
+        ::close(fds[0]);
+        ::close(fds[1]);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    ::close(fds[1]);
+    channel = fds[0];
+    fcntl(channel, F_SETFL, fcntl(channel, F_GETFL) | O_NONBLOCK);
+#endif
+
+    eof = false;
+    read_buffer.clear();
+    return true;
+}
+
+void SimWorkerProcess::kill() {
+#ifdef _WIN32
+    if (process) {
+        TerminateProcess(process, 1);
+        WaitForSingleObject(process, INFINITE);
+        CloseHandle(process);
+        process = nullptr;
+    }
+    if (stdin_write) {
+        CloseHandle(stdin_write);
+        stdin_write = nullptr;
+    }
+    if (stdout_read) {
+        CloseHandle(stdout_read);
+        stdout_read = nullptr;
+    }
+#else
+    if (pid > 0) {
+        ::kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        pid = -1;
+    }
+    if (channel >= 0) {
+        ::close(channel);
+        channel = -1;
+    }
+#endif
+    ring.detach();
+    shm.close();
+    read_buffer.clear();
+    eof = true;
+}
+
+bool SimWorkerProcess::is_alive() {
+    if (eof) {
+        return false;
+    }
+#ifdef _WIN32
+    return process && WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+#else
+    if (pid <= 0) {
+        return false;
+    }
+    int status;
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+        pid = -1;
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool SimWorkerProcess::send(const std::string &text) {
+    const char* data = text.c_str();
+    size_t remaining = text.size();
+
+#ifdef _WIN32
+    while (remaining > 0) {
+        DWORD written = 0;
+        if (!WriteFile(stdin_write, data, (DWORD)remaining, &written, nullptr)) {
+            eof = true;
+            return false;
+        }
+        data += written;
+        remaining -= written;
+    }
+#else
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    // A dead worker must not raise SIGPIPE in the host
+    flags = MSG_NOSIGNAL;
+#endif
+    while (remaining > 0) {
+        ssize_t written = ::send(channel, data, remaining, flags);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = { channel, POLLOUT, 0 };
+                poll(&pfd, 1, 100);
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            eof = true;
+            return false;
+        }
+        data += written;
+        remaining -= (size_t)written;
+    }
+#endif
+    return true;
+}
+
+bool SimWorkerProcess::read_line(std::string &line) {
+    size_t newline = read_buffer.find('\n');
+
+    // Pull whatever is available without blocking
+    if (newline == std::string::npos && !eof) {
+        char chunk[4096];
+#ifdef _WIN32
+        DWORD available = 0;
+        if (!PeekNamedPipe(stdout_read, nullptr, 0, nullptr, &available, nullptr)) {
+            eof = true;
+        }
+        while (available > 0) {
+            DWORD count = 0;
+            DWORD wanted = available < sizeof(chunk) ? available : (DWORD)sizeof(chunk);
+            if (!ReadFile(stdout_read, chunk, wanted, &count, nullptr) || count == 0) {
+                eof = true;
+                break;
+            }
+            read_buffer.append(chunk, count);
+            available -= count;
+        }
+#else
+        while (true) {
+            ssize_t count = ::read(channel, chunk, sizeof(chunk));
+            if (count > 0) {
+                read_buffer.append(chunk, (size_t)count);
+                continue;
+            }
+            if (count == 0) {
+                eof = true;
+            } else if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                eof = true;
+            }
+            break;
+        }
+#endif
+        newline = read_buffer.find('\n');
+    }
+
+    if (newline == std::string::npos) {
+        return false;
+    }
+
+    line.assign(read_buffer, 0, newline);
+    read_buffer.erase(0, newline + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return true;
+}
+
+SimRing &SimWorkerProcess::get_ring() {
+    return ring;
+}
+
+size_t SimAnalysis::get_row_count() const {
+    return vector_names.empty() ? 0 : rows.size() / vector_names.size();
+}
+
+void SimAnalysis::copy_vector(size_t column, double *out) const {
+    size_t width = vector_names.size();
+    size_t count = get_row_count();
+    const double *source = rows.data() + column;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = source[i * width];
+    }
+}
+
+SimProcessPool::SimProcessPool() {
+    next_job_id = 1;
+    ring_capacity = 0;
+}
+
+SimProcessPool::~SimProcessPool() {
+    stop();
+}
+
+bool SimProcessPool::spawn(Worker &worker, std::string &error) {
+    worker.job_id = -1;
+    worker.replies_expected = 0;
+    worker.replies_received = 0;
+    worker.names_expected = 0;
+    worker.generation = 0;
+    worker.failed = false;
+    return worker.process.start(executable, library, ring_capacity, error);
+}
+
+bool SimProcessPool::start(const std::string &worker_executable, const std::string &library_path, int worker_count,
+        uint64_t ring_doubles, std::string &error) {
+    stop();
+
+    executable = worker_executable;
+    library = library_path;
+    ring_capacity = ring_doubles;
+
+    for (int i = 0; i < worker_count; i++) {
+        std::unique_ptr<Worker> worker(new Worker());
+        if (!spawn(*worker, error)) {
+            stop();
+            return false;
+        }
+        workers.push_back(std::move(worker));
+    }
+    return true;
+}
+
+void SimProcessPool::stop() {
+    for (std::unique_ptr<Worker> &worker : workers) {
+        worker->process.send("quit\n");
+        worker->process.kill();
+    }
+    workers.clear();
+    queue.clear();
+
+    for (auto &entry : jobs) {
+        if (entry.second.state == SimJob::QUEUED || entry.second.state == SimJob::RUNNING) {
+            entry.second.state = SimJob::FAILED;
+            entry.second.error = "pool stopped";
+        }
+    }
+}
+
+bool SimProcessPool::is_started() const {
+    return !workers.empty();
+}
+
+int SimProcessPool::get_worker_count() const {
+    return (int)workers.size();
+}
+
+int SimProcessPool::submit(const std::vector<std::string> &netlist, const std::vector<std::string> &commands,
+        double timeout) {
+    SimJob &job = jobs[next_job_id];
+    job.id = next_job_id++;
+    job.state = SimJob::QUEUED;
+    job.netlist = netlist;
+    job.commands = commands;
+    job.timeout = timeout;
+    job.wall_time = 0.0;
+    queue.push_back(job.id);
+    return job.id;
+}
+
+void SimProcessPool::dispatch(Worker &worker, SimJob &job) {
+    std::string request = "circ " + std::to_string(job.netlist.size()) + "\n";
+    for (const std::string &line : job.netlist) {
+        request += line;
+        request += '\n';
+    }
+    for (const std::string &command : job.commands) {
+        request += "cmd " + command + "\n";
+    }
+
+    worker.job_id = job.id;
+    worker.replies_expected = 1 + (int)job.commands.size();
+    worker.replies_received = 0;
+    worker.names_expected = 0;
+    worker.failed = false;
+    worker.started = std::chrono::steady_clock::now();
+
+    job.state = SimJob::RUNNING;
+    job.analyses.clear();
+    worker.process.send(request);
+}
+
+void SimProcessPool::drain_ring(Worker &worker, SimJob &job) {
+    SimRing &ring = worker.process.get_ring();
+
+    // Rows of an analysis whose "init" has not been read yet stay in the ring
+    if (job.analyses.empty() || job.analyses.back().vector_names.empty()
+        || ring.generation() != worker.generation) {
+        return;
+    }
+
+    // Rows keep the ring layout, so each span is one block copy
+    std::vector<double> &rows = job.analyses.back().rows;
+    uint64_t count;
+    const double* values = ring.peek(count);
+    while (count > 0) {
+        rows.insert(rows.end(), values, values + count);
+        ring.consume(count);
+        values = ring.peek(count);
+    }
+}
+
+void SimProcessPool::finish_job(Worker &worker, bool success, const std::string &error, std::vector<int> &finished) {
+    auto it = jobs.find(worker.job_id);
+    worker.job_id = -1;
+    if (it == jobs.end()) {
+        return;
+    }
+
+    SimJob &job = it->second;
+    job.state = success ? SimJob::DONE : SimJob::FAILED;
+    if (!success && job.error.empty()) {
+        job.error = error;
+    }
+    job.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - worker.started).count();
+    finished.push_back(job.id);
+}
+
+void SimProcessPool::handle_line(Worker &worker, const std::string &line, std::vector<int> &finished) {
+    auto it = jobs.find(worker.job_id);
+    SimJob* job = it != jobs.end() ? &it->second : nullptr;
+
+    if (worker.names_expected > 0) {
+        worker.names_expected--;
+        if (job && !job->analyses.empty()) {
+            job->analyses.back().vector_names.push_back(line);
+        }
+        if (worker.names_expected == 0) {
+            worker.generation++;
+        }
+        return;
+    }
+
+    if (line == "ok" || line.compare(0, 4, "err ") == 0) {
+        if (line != "ok") {
+            worker.failed = true;
+            if (job && job->error.empty()) {
+                job->error = line.substr(4);
+            }
+        }
+        if (++worker.replies_received == worker.replies_expected && job) {
+            // All rows of the last command were written before its reply
+            drain_ring(worker, *job);
+            finish_job(worker, !worker.failed, "", finished);
+        }
+    } else if (line.compare(0, 5, "init ") == 0) {
+        // The worker waits for the ring to drain before announcing a new
+        // analysis, so everything still in the ring belongs to this one
+        worker.names_expected = atoi(line.c_str() + 5);
+        if (worker.names_expected == 0) {
+            worker.generation++;
+        }
+        if (job) {
+            job->analyses.emplace_back();
+        }
+    } else if (line.compare(0, 4, "out ") == 0) {
+        if (job) {
+            job->output.push_back(line.substr(4));
+        }
+    } else if (line.compare(0, 5, "exit ") == 0) {
+        if (job && job->error.empty()) {
+            job->error = "ngspice exited with status " + line.substr(5);
+        }
+    }
+}
+
+void SimProcessPool::poll(std::vector<int> &finished, std::vector<int> &crashed_workers) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        Worker &worker = *workers[i];
+
+        if (worker.job_id >= 0) {
+            auto it = jobs.find(worker.job_id);
+            if (it != jobs.end()) {
+                drain_ring(worker, it->second);
+            }
+        }
+
+        std::string line;
+        while (worker.process.read_line(line)) {
+            handle_line(worker, line, finished);
+        }
+
+        bool restart = false;
+        if (!worker.process.is_alive()) {
+            // Pick up a reply written just before the process went away
+            while (worker.process.read_line(line)) {
+                handle_line(worker, line, finished);
+            }
+            if (worker.job_id >= 0) {
+                finish_job(worker, false, "worker process exited", finished);
+            }
+            restart = true;
+        } else if (worker.job_id >= 0) {
+            auto it = jobs.find(worker.job_id);
+            double elapsed = std::chrono::duration<double>(now - worker.started).count();
+            if (it != jobs.end() && it->second.timeout > 0.0 && elapsed > it->second.timeout) {
+                finish_job(worker, false, "timed out", finished);
+                restart = true;
+            }
+        }
+
+        if (restart) {
+            crashed_workers.push_back((int)i);
+            std::string error;
+            if (!spawn(worker, error)) {
+                continue;
+            }
+        }
+
+        if (worker.job_id < 0 && !queue.empty()) {
+            int job_id = queue.front();
+            queue.pop_front();
+            auto it = jobs.find(job_id);
+            if (it != jobs.end()) {
+                dispatch(worker, it->second);
+            }
+        }
+    }
+}
+
+SimJob* SimProcessPool::get_job(int id) {
+    auto it = jobs.find(id);
+    return it != jobs.end() ? &it->second : nullptr;
+}
+
+void SimProcessPool::release_job(int id) {
+    auto it = jobs.find(id);
+    if (it == jobs.end()) {
+        return;
+    }
+    if (it->second.state == SimJob::QUEUED) {
+        for (auto q = queue.begin(); q != queue.end(); ++q) {
+            if (*q == id) {
+                queue.erase(q);
+                break;
+            }
+        }
+    }
+    if (it->second.state != SimJob::RUNNING) {
+        jobs.erase(it);
+    }
+}
+
+int SimProcessPool::get_pending_count() const {
+    int count = 0;
+    for (const auto &entry : jobs) {
+        if (entry.second.state == SimJob::QUEUED || entry.second.state == SimJob::RUNNING) {
+            count++;
+        }
+    }
+    return count;
+}
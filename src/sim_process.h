@@ -0,0 +1,152 @@
+#ifndef SIM_PROCESS_H
+#define SIM_PROCESS_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+#include "sim_ring.h"
+
+// Host side of the out-of-process simulation backend. Does not depend on
+// Godot, so it is shared by SimWorkerPool and the headless tools.
+//
+// Line protocol on the worker's stdin/stdout:
+//   host -> worker:  "circ <n>" followed by n netlist lines
+//                    "cmd <command>"     (run in the foreground; bg_*
+//                                         commands are waited for)
+//                    "quit"
+//   worker -> host:  "ok" | "err <message>"        reply to each circ/cmd
+//                    "init <n>" followed by n names  new analysis; each ring
+//                                                    row then holds n values
+//                    "out <text>"                    ngspice console output
+//                    "exit <status>"                 ngspice requested exit
+//
+// Vector data does not go through the pipe: every accepted timepoint is
+// written as one row into a SimRing in shared memory.
+
+// A single worker process with its pipe and result ring
+class SimWorkerProcess {
+private:
+    SimSharedMemory shm;
+    SimRing ring;
+    std::string read_buffer;
+    bool eof;
+
+#ifdef _WIN32
+    HANDLE process;
+    HANDLE stdin_write;
+    HANDLE stdout_read;
+#else
+    pid_t pid;
+    int channel;
+#endif
+
+public:
+    SimWorkerProcess();
+    ~SimWorkerProcess();
+
+    bool start(const std::string &executable, const std::string &library, uint64_t ring_capacity, std::string &error);
+    void kill();
+    bool is_alive();
+
+    bool send(const std::string &text);
+    // Non-blocking; returns false when no complete line is buffered
+    bool read_line(std::string &line);
+
+    SimRing &get_ring();
+};
+
+// Vectors of one analysis, row by row as the worker wrote them
+// (vector_names.size() values per accepted point)
+struct SimAnalysis {
+    std::vector<std::string> vector_names;
+    std::vector<double> rows;
+
+    size_t get_row_count() const;
+    // Writes get_row_count() values of one vector to 'out'
+    void copy_vector(size_t column, double *out) const;
+};
+
+struct SimJob {
+    enum State {
+        QUEUED,
+        RUNNING,
+        DONE,
+        FAILED
+    };
+
+    int id;
+    State state;
+    std::vector<std::string> netlist;
+    std::vector<std::string> commands;
+    double timeout;         // Seconds, 0 for no limit
+    double wall_time;       // Seconds between dispatch and completion
+    std::string error;
+    std::vector<std::string> output;
+
+    // One entry per "init" the worker announced, in command order
+    std::vector<SimAnalysis> analyses;
+};
+
+// Pool of worker processes running queued jobs. A crash, hang or
+// controlled exit of ngspice only fails the job on that worker; the worker
+// is restarted and the pool keeps going.
+class SimProcessPool {
+private:
+    struct Worker {
+        SimWorkerProcess process;
+        int job_id;              // -1 when idle
+        int replies_expected;
+        int replies_received;
+        int names_expected;      // Name lines still to come after "init"
+        uint32_t generation;     // Ring generation of the announced analysis
+        bool failed;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::map<int, SimJob> jobs;
+    std::deque<int> queue;
+    int next_job_id;
+
+    std::string executable;
+    std::string library;
+    uint64_t ring_capacity;
+
+    bool spawn(Worker &worker, std::string &error);
+    void dispatch(Worker &worker, SimJob &job);
+    void drain_ring(Worker &worker, SimJob &job);
+    void handle_line(Worker &worker, const std::string &line, std::vector<int> &finished);
+    void finish_job(Worker &worker, bool success, const std::string &error, std::vector<int> &finished);
+
+public:
+    SimProcessPool();
+    ~SimProcessPool();
+
+    bool start(const std::string &worker_executable, const std::string &library_path, int worker_count,
+        uint64_t ring_doubles, std::string &error);
+    void stop();
+    bool is_started() const;
+    int get_worker_count() const;
+
+    int submit(const std::vector<std::string> &netlist, const std::vector<std::string> &commands, double timeout);
+
+    // Pumps pipes and rings, dispatches queued jobs, enforces timeouts and
+    // restarts dead workers. Ids of jobs that completed (done or failed) and
+    // indices of workers that had to be restarted are appended.
+    void poll(std::vector<int> &finished, std::vector<int> &crashed_workers);
+
+    SimJob* get_job(int id);
+    void release_job(int id);
+    int get_pending_count() const;
+};
+
+#endif // SIM_PROCESS_H
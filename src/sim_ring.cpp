@@ -0,0 +1,244 @@
+#include "sim_ring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SimRing::SimRing() {
+    header = nullptr;
+    data = nullptr;
+}
+
+size_t SimRing::bytes_for(uint64_t capacity) {
+    return sizeof(SimRingHeader) + capacity * sizeof(double);
+}
+
+void SimRing::create(void* memory, uint64_t capacity) {
+    header = new (memory) SimRingHeader();
+    header->magic = SIM_RING_MAGIC;
+    header->version = SIM_RING_VERSION;
+    header->capacity = capacity;
+    header->write_pos.store(0, std::memory_order_relaxed);
+    header->read_pos.store(0, std::memory_order_relaxed);
+    header->generation.store(0, std::memory_order_relaxed);
+    data = reinterpret_cast<double*>(header + 1);
+}
+
+bool SimRing::attach(void* memory) {
+    SimRingHeader* candidate = static_cast<SimRingHeader*>(memory);
+    if (candidate->magic != SIM_RING_MAGIC || candidate->version != SIM_RING_VERSION) {
+        return false;
+    }
+    header = candidate;
+    data = reinterpret_cast<double*>(header + 1);
+    return true;
+}
+
+void SimRing::detach() {
+    header = nullptr;
+    data = nullptr;
+}
+
+bool SimRing::is_attached() const {
+    return header != nullptr;
+}
+
+uint64_t SimRing::capacity() const {
+    return header ? header->capacity : 0;
+}
+
+uint32_t SimRing::generation() const {
+    return header->generation.load(std::memory_order_acquire);
+}
+
+void SimRing::next_generation() {
+    header->generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool SimRing::write(const double* values, uint64_t count) {
+    uint64_t write_pos = header->write_pos.load(std::memory_order_relaxed);
+    uint64_t read_pos = header->read_pos.load(std::memory_order_acquire);
+    if (count > header->capacity - (write_pos - read_pos)) {
+        return false;
+    }
+
+    // Copy in at most two pieces around the wrap point
+    uint64_t offset = write_pos % header->capacity;
+    uint64_t first = header->capacity - offset;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(data + offset, values, first * sizeof(double));
+    memcpy(data, values + first, (count - first) * sizeof(double));
+
+    header->write_pos.store(write_pos + count, std::memory_order_release);
+    return true;
+}
+
+bool SimRing::is_empty() const {
+    return header->read_pos.load(std::memory_order_acquire) ==
+        header->write_pos.load(std::memory_order_acquire);
+}
+
+const double* SimRing::peek(uint64_t &count) const {
+    uint64_t read_pos = header->read_pos.load(std::memory_order_relaxed);
+    uint64_t write_pos = header->write_pos.load(std::memory_order_acquire);
+
+    uint64_t offset = read_pos % header->capacity;
+    count = write_pos - read_pos;
+    if (count > header->capacity - offset) {
+        count = header->capacity - offset;
+    }
+    return data + offset;
+}
+
+void SimRing::consume(uint64_t count) {
+    header->read_pos.fetch_add(count, std::memory_order_release);
+}
+
+SimSharedMemory::SimSharedMemory() {
+    memory = nullptr;
+    size = 0;
+    owner = false;
+#ifdef _WIN32
+    mapping = nullptr;
+#endif
+}
+
+SimSharedMemory::~SimSharedMemory() {
+    close();
+}
+
+bool SimSharedMemory::create(const std::string &shm_name, size_t bytes, std::string &error) {
+    close();
+
+#ifdef _WIN32
+    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        (DWORD)((uint64_t)bytes >> 32), (DWORD)(bytes & 0xffffffff), shm_name.c_str());
+    if (!mapping) {
+        error = "CreateFileMapping failed for " + shm_name;
+        return false;
+    }
+    memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!memory) {
+        error = "MapViewOfFile failed for " + shm_name;
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+#else
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        error = "shm_open failed for " + shm_name + ": " + strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        error = "ftruncate failed for " + shm_name + ": " + strerror(errno);
+        ::close(fd);
+        shm_unlink(shm_name.c_str());
+        return false;
+    }
+    memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        error = "mmap failed for " + shm_name + ": " + strerror(errno);
+        memory = nullptr;
+        shm_unlink(shm_name.c_str());
+        return false;
+    }
+#endif
+
+    name = shm_name;
+    size = bytes;
+    owner = true;
+    return true;
+}
+
+bool SimSharedMemory::open(const std::string &shm_name, std::string &error) {
+    close();
+
+#ifdef _WIN32
+    mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, shm_name.c_str());
+    if (!mapping) {
+        error = "OpenFileMapping failed for " + shm_name;
+        return false;
+    }
+    memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!memory) {
+        error = "MapViewOfFile failed for " + shm_name;
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(memory, &info, sizeof(info));
+    size = info.RegionSize;
+#else
+    int fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        error = "shm_open failed for " + shm_name + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        error = "fstat failed for " + shm_name + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size = (size_t)st.st_size;
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        error = "mmap failed for " + shm_name + ": " + strerror(errno);
+        memory = nullptr;
+        size = 0;
+        return false;
+    }
+#endif
+
+    name = shm_name;
+    owner = false;
+    return true;
+}
+
+void SimSharedMemory::close() {
+#ifdef _WIN32
+    if (memory) {
+        UnmapViewOfFile(memory);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+#else
+    if (memory) {
+        munmap(memory, size);
+    }
+    if (owner && !name.empty()) {
+        shm_unlink(name.c_str());
+    }
+#endif
+    memory = nullptr;
+    size = 0;
+    owner = false;
+    name.clear();
+}
+
+void* SimSharedMemory::get_memory() const {
+    return memory;
+}
+
+size_t SimSharedMemory::get_size() const {
+    return size;
+}
+
+const std::string &SimSharedMemory::get_name() const {
+    return name;
+}
@@ -0,0 +1,86 @@
+#ifndef SIM_RING_H
+#define SIM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Layout of the shared-memory block between the host and a simulation
+// worker process. One producer (worker) and one consumer (host).
+struct SimRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;                // Ring size in doubles
+    std::atomic<uint64_t> write_pos;  // Total doubles written
+    std::atomic<uint64_t> read_pos;   // Total doubles consumed
+    std::atomic<uint32_t> generation; // Bumped by the producer per analysis
+};
+
+static const uint32_t SIM_RING_MAGIC = 0x474e5253;  // "SRNG"
+static const uint32_t SIM_RING_VERSION = 1;
+
+// Lock-free single-producer/single-consumer ring of doubles. The worker
+// writes one row (all vector values of one accepted timepoint) at a time;
+// the host reads the values in place from the mapping.
+class SimRing {
+private:
+    SimRingHeader* header;
+    double* data;
+
+public:
+    SimRing();
+
+    static size_t bytes_for(uint64_t capacity);
+
+    // Initialize a fresh block (host) or attach to an initialized one (worker)
+    void create(void* memory, uint64_t capacity);
+    bool attach(void* memory);
+    void detach();
+    bool is_attached() const;
+
+    uint64_t capacity() const;
+
+    // Analysis counter, so the consumer never reads rows of an analysis
+    // whose row width it has not been told about yet
+    uint32_t generation() const;
+    void next_generation();
+
+    // Producer: writes all 'count' values or nothing
+    bool write(const double* values, uint64_t count);
+    bool is_empty() const;
+
+    // Consumer: contiguous span of unread values (up to the wrap point)
+    const double* peek(uint64_t &count) const;
+    void consume(uint64_t count);
+};
+
+// Named shared-memory mapping holding a SimRing
+class SimSharedMemory {
+private:
+    std::string name;
+    void* memory;
+    size_t size;
+    bool owner;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+
+public:
+    SimSharedMemory();
+    ~SimSharedMemory();
+
+    bool create(const std::string &shm_name, size_t bytes, std::string &error);
+    bool open(const std::string &shm_name, std::string &error);
+    void close();
+
+    void* get_memory() const;
+    size_t get_size() const;
+    const std::string &get_name() const;
+};
+
+#endif // SIM_RING_H
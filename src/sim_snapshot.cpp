@@ -0,0 +1,152 @@
+#include "sim_snapshot.h"
+#include "circuit_sim.h"
+
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include <algorithm>
+
+using namespace godot;
+
+void SimSnapshot::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_generation"), &SimSnapshot::get_generation);
+    ClassDB::bind_method(D_METHOD("get_row_count"), &SimSnapshot::get_row_count);
+    ClassDB::bind_method(D_METHOD("get_vector_names"), &SimSnapshot::get_vector_names);
+    ClassDB::bind_method(D_METHOD("has_vector", "vector_name"), &SimSnapshot::has_vector);
+    ClassDB::bind_method(D_METHOD("get_start_time"), &SimSnapshot::get_start_time);
+    ClassDB::bind_method(D_METHOD("get_end_time"), &SimSnapshot::get_end_time);
+
+    ClassDB::bind_method(D_METHOD("get_time"), &SimSnapshot::get_time);
+    ClassDB::bind_method(D_METHOD("get_vector", "vector_name", "begin", "end"), &SimSnapshot::get_vector, DEFVAL(0), DEFVAL(-1));
+    ClassDB::bind_method(D_METHOD("get_value", "vector_name", "row"), &SimSnapshot::get_value);
+    ClassDB::bind_method(D_METHOD("find_row", "time"), &SimSnapshot::find_row);
+    ClassDB::bind_method(D_METHOD("get_range", "vector_name", "t0", "t1"), &SimSnapshot::get_range);
+    ClassDB::bind_method(D_METHOD("until", "time"), &SimSnapshot::until);
+}
+
+SimSnapshot::SimSnapshot() {
+}
+
+void SimSnapshot::setup(const std::shared_ptr<const StreamSnapshot> &p_snapshot) {
+    snapshot = p_snapshot;
+}
+
+int SimSnapshot::find_column(const String &vector_name) const {
+    if (!snapshot) {
+        return -1;
+    }
+    return snapshot->find_column(CircuitSimulator::probe_key(vector_name.utf8().get_data()));
+}
+
+int64_t SimSnapshot::get_generation() const {
+    return snapshot ? (int64_t)snapshot->get_layout().generation : 0;
+}
+
+int64_t SimSnapshot::get_row_count() const {
+    return snapshot ? (int64_t)snapshot->get_row_count() : 0;
+}
+
+PackedStringArray SimSnapshot::get_vector_names() const {
+    PackedStringArray names;
+    if (snapshot) {
+        for (const std::string &name : snapshot->get_layout().names) {
+            names.push_back(String(name.c_str()));
+        }
+    }
+    return names;
+}
+
+bool SimSnapshot::has_vector(const String &vector_name) const {
+    return find_column(vector_name) >= 0;
+}
+
+double SimSnapshot::get_start_time() const {
+    if (!snapshot || snapshot->get_row_count() == 0) {
+        return 0.0;
+    }
+    return snapshot->get_value(snapshot->get_layout().scale, 0);
+}
+
+double SimSnapshot::get_end_time() const {
+    if (!snapshot || snapshot->get_row_count() == 0) {
+        return 0.0;
+    }
+    return snapshot->get_value(snapshot->get_layout().scale, snapshot->get_row_count() - 1);
+}
+
+PackedFloat64Array SimSnapshot::get_time() const {
+    PackedFloat64Array result;
+    if (snapshot) {
+        result.resize(snapshot->get_row_count());
+        snapshot->copy_column(snapshot->get_layout().scale, 0, snapshot->get_row_count(), result.ptrw());
+    }
+    return result;
+}
+
+PackedFloat64Array SimSnapshot::get_vector(const String &vector_name, int64_t begin, int64_t end) const {
+    PackedFloat64Array result;
+    int column = find_column(vector_name);
+    if (column < 0) {
+        UtilityFunctions::printerr("Vector not in snapshot: " + vector_name);
+        return result;
+    }
+
+    int64_t rows = (int64_t)snapshot->get_row_count();
+    if (end < 0 || end > rows) {
+        end = rows;
+    }
+    begin = std::max<int64_t>(begin, 0);
+    if (begin >= end) {
+        return result;
+    }
+    result.resize(end - begin);
+    snapshot->copy_column(column, (size_t)begin, (size_t)end, result.ptrw());
+    return result;
+}
+
+double SimSnapshot::get_value(const String &vector_name, int64_t row) const {
+    int column = find_column(vector_name);
+    if (column < 0 || row < 0 || row >= (int64_t)snapshot->get_row_count()) {
+        UtilityFunctions::printerr("No value for " + vector_name + " at row " + String::num_int64(row));
+        return 0.0;
+    }
+    return snapshot->get_value(column, (size_t)row);
+}
+
+int64_t SimSnapshot::find_row(double time) const {
+    // Last row at or before 'time', -1 if none
+    return snapshot ? (int64_t)snapshot->count_rows_until(time) - 1 : -1;
+}
+
+Dictionary SimSnapshot::get_range(const String &vector_name, double t0, double t1) const {
+    Dictionary result;
+    int column = find_column(vector_name);
+    if (column < 0) {
+        UtilityFunctions::printerr("Vector not in snapshot: " + vector_name);
+        return result;
+    }
+
+    // Rows with t0 <= time <= t1
+    size_t begin = snapshot->count_rows_before(t0);
+    size_t end = std::max(begin, snapshot->count_rows_until(t1));
+
+    PackedFloat64Array time;
+    PackedFloat64Array values;
+    time.resize(end - begin);
+    values.resize(end - begin);
+    if (end > begin) {
+        snapshot->copy_column(snapshot->get_layout().scale, begin, end, time.ptrw());
+        snapshot->copy_column(column, begin, end, values.ptrw());
+    }
+    result["time"] = time;
+    result["values"] = values;
+    return result;
+}
+
+Ref<SimSnapshot> SimSnapshot::until(double time) const {
+    Ref<SimSnapshot> view;
+    view.instantiate();
+    if (snapshot) {
+        view->setup(snapshot->truncated(snapshot->count_rows_until(time)));
+    }
+    return view;
+}
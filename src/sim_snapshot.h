@@ -0,0 +1,53 @@
+#ifndef SIM_SNAPSHOT_H
+#define SIM_SNAPSHOT_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/dictionary.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <memory>
+
+#include "stream_snapshot.h"
+
+namespace godot {
+
+// Immutable view of streamed vectors up to some row, as published by
+// CircuitSimulator. Safe to read from any thread while the simulation keeps
+// running; only the getters' results are copies.
+class SimSnapshot : public RefCounted {
+    GDCLASS(SimSnapshot, RefCounted)
+
+private:
+    std::shared_ptr<const StreamSnapshot> snapshot;
+
+    int find_column(const String &vector_name) const;
+
+protected:
+    static void _bind_methods();
+
+public:
+    SimSnapshot();
+
+    void setup(const std::shared_ptr<const StreamSnapshot> &p_snapshot);
+
+    int64_t get_generation() const;
+    int64_t get_row_count() const;
+    PackedStringArray get_vector_names() const;
+    bool has_vector(const String &vector_name) const;
+    double get_start_time() const;
+    double get_end_time() const;
+
+    PackedFloat64Array get_time() const;
+    PackedFloat64Array get_vector(const String &vector_name, int64_t begin = 0, int64_t end = -1) const;
+    double get_value(const String &vector_name, int64_t row) const;
+    int64_t find_row(double time) const;
+    Dictionary get_range(const String &vector_name, double t0, double t1) const;
+
+    // Shares this snapshot's data
+    Ref<SimSnapshot> until(double time) const;
+};
+
+} // namespace godot
+
+#endif // SIM_SNAPSHOT_H
@@ -0,0 +1,194 @@
+#include "sim_vector.h"
+#include "circuit_sim.h"
+
+#include <cstring>
+
+using namespace godot;
+
+// Vector types and flags from ngspice (sim.h / dvec.h)
+enum {
+    SV_NOTYPE = 0,
+    SV_TIME,
+    SV_FREQUENCY,
+    SV_VOLTAGE,
+    SV_CURRENT,
+    SV_OUTPUT_N_DENS,
+    SV_OUTPUT_NOISE,
+    SV_INPUT_N_DENS,
+    SV_INPUT_NOISE,
+    SV_POLE,
+    SV_ZERO,
+    SV_SPARAM,
+    SV_TEMP,
+    SV_RES,
+    SV_IMPEDANCE,
+    SV_ADMITTANCE,
+    SV_POWER,
+    SV_PHASE,
+    SV_DB,
+    SV_CAPACITANCE,
+    SV_CHARGE
+};
+
+static const short VF_COMPLEX = (1 << 1);
+
+void SimVector::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_name"), &SimVector::get_name);
+    ClassDB::bind_method(D_METHOD("get_plot"), &SimVector::get_plot);
+    ClassDB::bind_method(D_METHOD("get_length"), &SimVector::get_length);
+    ClassDB::bind_method(D_METHOD("get_type"), &SimVector::get_type);
+    ClassDB::bind_method(D_METHOD("get_units"), &SimVector::get_units);
+    ClassDB::bind_method(D_METHOD("is_complex"), &SimVector::is_complex);
+    ClassDB::bind_method(D_METHOD("is_valid"), &SimVector::is_valid);
+
+    ClassDB::bind_method(D_METHOD("get_data"), &SimVector::get_data);
+    ClassDB::bind_method(D_METHOD("slice", "begin", "end"), &SimVector::slice);
+    ClassDB::bind_method(D_METHOD("get_value", "index"), &SimVector::get_value);
+    ClassDB::bind_method(D_METHOD("get_imag_data"), &SimVector::get_imag_data);
+}
+
+SimVector::SimVector() {
+    info_cached = false;
+    type = SV_NOTYPE;
+    complex = false;
+}
+
+void SimVector::setup(CircuitSimulator *simulator, const String &plot, const String &name) {
+    simulator_id = simulator ? ObjectID(simulator->get_instance_id()) : ObjectID();
+    plot_name = plot;
+    vector_name = name;
+    info_cached = false;
+}
+
+pvector_info SimVector::fetch_info() {
+    CircuitSimulator *simulator = Object::cast_to<CircuitSimulator>(ObjectDB::get_instance(simulator_id));
+    if (!simulator) {
+        return nullptr;
+    }
+
+    // Qualify with the plot name so the handle stays bound to its plot
+    // even after later analyses change the current plot
+    pvector_info vec = simulator->get_vector_info(plot_name + "." + vector_name);
+    if (vec && !info_cached) {
+        type = vec->v_type;
+        complex = (vec->v_flags & VF_COMPLEX) != 0;
+        info_cached = true;
+    }
+    return vec;
+}
+
+String SimVector::get_name() const {
+    return vector_name;
+}
+
+String SimVector::get_plot() const {
+    return plot_name;
+}
+
+int SimVector::get_length() {
+    pvector_info vec = fetch_info();
+    return vec ? vec->v_length : 0;
+}
+
+int SimVector::get_type() {
+    if (!info_cached) {
+        fetch_info();
+    }
+    return type;
+}
+
+String SimVector::get_units() {
+    switch (get_type()) {
+        case SV_TIME: return "s";
+        case SV_FREQUENCY: return "Hz";
+        case SV_VOLTAGE: return "V";
+        case SV_CURRENT: return "A";
+        case SV_OUTPUT_N_DENS:
+        case SV_INPUT_N_DENS: return "V^2/Hz";
+        case SV_OUTPUT_NOISE:
+        case SV_INPUT_NOISE: return "V";
+        case SV_TEMP: return "C";
+        case SV_RES:
+        case SV_IMPEDANCE: return "Ohm";
+        case SV_ADMITTANCE: return "S";
+        case SV_POWER: return "W";
+        case SV_PHASE: return "rad";
+        case SV_DB: return "dB";
+        case SV_CAPACITANCE: return "F";
+        case SV_CHARGE: return "C";
+        default: return "";
+    }
+}
+
+bool SimVector::is_complex() {
+    if (!info_cached) {
+        fetch_info();
+    }
+    return complex;
+}
+
+bool SimVector::is_valid() {
+    return fetch_info() != nullptr;
+}
+
+PackedFloat64Array SimVector::get_data() {
+    return slice(0, INT32_MAX);
+}
+
+PackedFloat64Array SimVector::slice(int begin, int end) {
+    PackedFloat64Array result;
+
+    pvector_info vec = fetch_info();
+    if (!vec) {
+        return result;
+    }
+
+    // Same index rules as Array.slice: negative indices count from the end
+    int length = vec->v_length;
+    if (begin < 0) {
+        begin += length;
+    }
+    if (end < 0) {
+        end += length;
+    }
+    begin = begin < 0 ? 0 : (begin > length ? length : begin);
+    end = end < begin ? begin : (end > length ? length : end);
+
+    result.resize(end - begin);
+    double *dst = result.ptrw();
+    if (vec->v_realdata) {
+        memcpy(dst, vec->v_realdata + begin, sizeof(double) * (end - begin));
+    } else if (vec->v_compdata) {
+        for (int i = begin; i < end; i++) {
+            dst[i - begin] = vec->v_compdata[i].cx_real;
+        }
+    }
+    return result;
+}
+
+double SimVector::get_value(int index) {
+    pvector_info vec = fetch_info();
+    if (!vec || index < 0 || index >= vec->v_length) {
+        return 0.0;
+    }
+    if (vec->v_realdata) {
+        return vec->v_realdata[index];
+    }
+    return vec->v_compdata ? vec->v_compdata[index].cx_real : 0.0;
+}
+
+PackedFloat64Array SimVector::get_imag_data() {
+    PackedFloat64Array result;
+
+    pvector_info vec = fetch_info();
+    if (!vec || !vec->v_compdata) {
+        return result;
+    }
+
+    result.resize(vec->v_length);
+    double *dst = result.ptrw();
+    for (int i = 0; i < vec->v_length; i++) {
+        dst[i] = vec->v_compdata[i].cx_imag;
+    }
+    return result;
+}
@@ -0,0 +1,59 @@
+#ifndef SIM_VECTOR_H
+#define SIM_VECTOR_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/core/object_id.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include "sharedspice.h"
+
+namespace godot {
+
+class CircuitSimulator;
+
+// Lightweight handle to a vector of a simulation plot. Only the plot and
+// vector name are stored; metadata is fetched on first use and samples are
+// copied out of ngspice only when requested.
+class SimVector : public RefCounted {
+    GDCLASS(SimVector, RefCounted)
+
+private:
+    ObjectID simulator_id;
+    String plot_name;
+    String vector_name;
+
+    // Type metadata cache, filled by fetch_info(). The length is not cached
+    // because it keeps growing while a simulation is running.
+    bool info_cached;
+    int type;
+    bool complex;
+
+    pvector_info fetch_info();
+
+protected:
+    static void _bind_methods();
+
+public:
+    SimVector();
+
+    void setup(CircuitSimulator *simulator, const String &plot, const String &name);
+
+    String get_name() const;
+    String get_plot() const;
+    int get_length();
+    int get_type();
+    String get_units();
+    bool is_complex();
+    bool is_valid();
+
+    // Data access (real part for complex vectors)
+    PackedFloat64Array get_data();
+    PackedFloat64Array slice(int begin, int end);
+    double get_value(int index);
+    PackedFloat64Array get_imag_data();
+};
+
+} // namespace godot
+
+#endif // SIM_VECTOR_H
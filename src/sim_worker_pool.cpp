@@ -0,0 +1,207 @@
+#include "sim_worker_pool.h"
+
+#include <godot_cpp/classes/os.hpp>
+#include <godot_cpp/classes/project_settings.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+void SimWorkerPool::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("start", "worker_count", "executable_path", "library_path", "ring_size"), &SimWorkerPool::start, DEFVAL(0), DEFVAL(""), DEFVAL(""), DEFVAL(1 << 20));
+    ClassDB::bind_method(D_METHOD("stop"), &SimWorkerPool::stop);
+    ClassDB::bind_method(D_METHOD("is_started"), &SimWorkerPool::is_started);
+    ClassDB::bind_method(D_METHOD("get_worker_count"), &SimWorkerPool::get_worker_count);
+
+    ClassDB::bind_method(D_METHOD("submit", "netlist_content", "commands", "timeout"), &SimWorkerPool::submit, DEFVAL(0.0));
+    ClassDB::bind_method(D_METHOD("poll"), &SimWorkerPool::poll);
+    ClassDB::bind_method(D_METHOD("get_pending_count"), &SimWorkerPool::get_pending_count);
+
+    ClassDB::bind_method(D_METHOD("get_job_state", "job_id"), &SimWorkerPool::get_job_state);
+    ClassDB::bind_method(D_METHOD("get_job_error", "job_id"), &SimWorkerPool::get_job_error);
+    ClassDB::bind_method(D_METHOD("get_job_output", "job_id"), &SimWorkerPool::get_job_output);
+    ClassDB::bind_method(D_METHOD("get_job_wall_time", "job_id"), &SimWorkerPool::get_job_wall_time);
+    ClassDB::bind_method(D_METHOD("get_job_analysis_count", "job_id"), &SimWorkerPool::get_job_analysis_count);
+    ClassDB::bind_method(D_METHOD("get_job_vector_names", "job_id", "analysis"), &SimWorkerPool::get_job_vector_names, DEFVAL(-1));
+    ClassDB::bind_method(D_METHOD("get_job_vector", "job_id", "vector_name", "analysis"), &SimWorkerPool::get_job_vector, DEFVAL(-1));
+    ClassDB::bind_method(D_METHOD("release_job", "job_id"), &SimWorkerPool::release_job);
+
+    BIND_ENUM_CONSTANT(JOB_QUEUED);
+    BIND_ENUM_CONSTANT(JOB_RUNNING);
+    BIND_ENUM_CONSTANT(JOB_DONE);
+    BIND_ENUM_CONSTANT(JOB_FAILED);
+    BIND_ENUM_CONSTANT(JOB_UNKNOWN);
+
+    ADD_SIGNAL(MethodInfo("job_finished", PropertyInfo(Variant::INT, "job_id"), PropertyInfo(Variant::BOOL, "success")));
+    ADD_SIGNAL(MethodInfo("worker_restarted", PropertyInfo(Variant::INT, "worker_index")));
+}
+
+SimWorkerPool::SimWorkerPool() {
+}
+
+SimWorkerPool::~SimWorkerPool() {
+    pool.stop();
+}
+
+String SimWorkerPool::resolve_executable_path(const String &executable_path) {
+    String executable = executable_path;
+    if (executable.is_empty()) {
+#ifdef _WIN32
+        executable = "res://bin/sim_worker.exe";
+#else
+        executable = "res://bin/sim_worker";
+#endif
+    }
+    return ProjectSettings::get_singleton()->globalize_path(executable);
+}
+
+bool SimWorkerPool::start(int worker_count, const String &executable_path, const String &library_path, int ring_size) {
+    if (worker_count <= 0) {
+        worker_count = OS::get_singleton()->get_processor_count();
+    }
+
+    String executable = resolve_executable_path(executable_path);
+
+    String library = library_path;
+    if (!library.is_empty()) {
+        library = ProjectSettings::get_singleton()->globalize_path(library);
+    }
+
+    std::string error;
+    if (!pool.start(executable.utf8().get_data(), library.utf8().get_data(), worker_count, (uint64_t)ring_size, error)) {
+        UtilityFunctions::printerr("Failed to start simulation workers: " + String(error.c_str()));
+        return false;
+    }
+
+    UtilityFunctions::print("Started " + String::num_int64(worker_count) + " simulation workers");
+    return true;
+}
+
+void SimWorkerPool::stop() {
+    pool.stop();
+}
+
+bool SimWorkerPool::is_started() const {
+    return pool.is_started();
+}
+
+int SimWorkerPool::get_worker_count() const {
+    return pool.get_worker_count();
+}
+
+int SimWorkerPool::submit(const String &netlist_content, const PackedStringArray &commands, double timeout) {
+    if (!pool.is_started()) {
+        UtilityFunctions::printerr("Simulation workers not started");
+        return -1;
+    }
+
+    // Split netlist into lines
+    PackedStringArray lines = netlist_content.split("\n");
+    std::vector<std::string> netlist;
+    netlist.reserve(lines.size());
+    for (int i = 0; i < lines.size(); i++) {
+        netlist.push_back(std::string(lines[i].utf8().get_data()));
+    }
+
+    std::vector<std::string> command_list;
+    for (int i = 0; i < commands.size(); i++) {
+        command_list.push_back(std::string(commands[i].utf8().get_data()));
+    }
+
+    return pool.submit(netlist, command_list, timeout);
+}
+
+void SimWorkerPool::poll() {
+    std::vector<int> finished;
+    std::vector<int> restarted;
+    pool.poll(finished, restarted);
+
+    for (int worker_index : restarted) {
+        emit_signal("worker_restarted", worker_index);
+    }
+    for (int job_id : finished) {
+        SimJob* job = pool.get_job(job_id);
+        emit_signal("job_finished", job_id, job && job->state == SimJob::DONE);
+    }
+}
+
+int SimWorkerPool::get_pending_count() const {
+    return pool.get_pending_count();
+}
+
+int SimWorkerPool::get_job_state(int job_id) {
+    SimJob* job = pool.get_job(job_id);
+    return job ? (int)job->state : (int)JOB_UNKNOWN;
+}
+
+String SimWorkerPool::get_job_error(int job_id) {
+    SimJob* job = pool.get_job(job_id);
+    return job ? String(job->error.c_str()) : String();
+}
+
+PackedStringArray SimWorkerPool::get_job_output(int job_id) {
+    PackedStringArray result;
+    SimJob* job = pool.get_job(job_id);
+    if (job) {
+        for (const std::string &line : job->output) {
+            result.append(String(line.c_str()));
+        }
+    }
+    return result;
+}
+
+double SimWorkerPool::get_job_wall_time(int job_id) {
+    SimJob* job = pool.get_job(job_id);
+    return job ? job->wall_time : 0.0;
+}
+
+const SimAnalysis *SimWorkerPool::get_analysis(int job_id, int analysis) {
+    SimJob* job = pool.get_job(job_id);
+    if (!job) {
+        return nullptr;
+    }
+    int count = (int)job->analyses.size();
+    if (analysis < 0) {
+        analysis += count;
+    }
+    return analysis >= 0 && analysis < count ? &job->analyses[analysis] : nullptr;
+}
+
+int SimWorkerPool::get_job_analysis_count(int job_id) {
+    SimJob* job = pool.get_job(job_id);
+    return job ? (int)job->analyses.size() : 0;
+}
+
+PackedStringArray SimWorkerPool::get_job_vector_names(int job_id, int analysis) {
+    PackedStringArray result;
+    const SimAnalysis *vectors = get_analysis(job_id, analysis);
+    if (vectors) {
+        for (const std::string &name : vectors->vector_names) {
+            result.append(String(name.c_str()));
+        }
+    }
+    return result;
+}
+
+PackedFloat64Array SimWorkerPool::get_job_vector(int job_id, const String &vector_name, int analysis) {
+    PackedFloat64Array result;
+    SimJob* job = pool.get_job(job_id);
+    const SimAnalysis *vectors = get_analysis(job_id, analysis);
+    if (!job || job->state != SimJob::DONE || !vectors) {
+        return result;
+    }
+
+    // One strided pass from the analysis' rows into the array
+    CharString name_utf8 = vector_name.utf8();
+    for (size_t i = 0; i < vectors->vector_names.size(); i++) {
+        if (vectors->vector_names[i] == name_utf8.get_data()) {
+            result.resize((int64_t)vectors->get_row_count());
+            vectors->copy_vector(i, result.ptrw());
+            break;
+        }
+    }
+    return result;
+}
+
+void SimWorkerPool::release_job(int job_id) {
+    pool.release_job(job_id);
+}
@@ -0,0 +1,68 @@
+#ifndef SIM_WORKER_POOL_H
+#define SIM_WORKER_POOL_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include "sim_process.h"
+
+namespace godot {
+
+// Out-of-process simulation backend. Each worker is a separate sim_worker
+// process with its own libngspice, so jobs run concurrently and an ngspice
+// crash only fails the job it was running. Call poll() regularly (e.g. from
+// _process) to collect results and dispatch queued jobs.
+class SimWorkerPool : public RefCounted {
+    GDCLASS(SimWorkerPool, RefCounted)
+
+private:
+    SimProcessPool pool;
+
+    const SimAnalysis *get_analysis(int job_id, int analysis);
+
+protected:
+    static void _bind_methods();
+
+public:
+    enum JobState {
+        JOB_QUEUED = SimJob::QUEUED,
+        JOB_RUNNING = SimJob::RUNNING,
+        JOB_DONE = SimJob::DONE,
+        JOB_FAILED = SimJob::FAILED,
+        JOB_UNKNOWN
+    };
+
+    SimWorkerPool();
+    ~SimWorkerPool();
+
+    bool start(int worker_count = 0, const String &executable_path = "", const String &library_path = "", int ring_size = 1 << 20);
+    void stop();
+    bool is_started() const;
+    int get_worker_count() const;
+
+    // Absolute path of the worker executable ("" = res://bin/sim_worker)
+    static String resolve_executable_path(const String &executable_path);
+
+    // Commands run to completion inside the worker, e.g. "tran 1u 1m"
+    int submit(const String &netlist_content, const PackedStringArray &commands, double timeout = 0.0);
+    void poll();
+    int get_pending_count() const;
+
+    // Job results
+    int get_job_state(int job_id);
+    String get_job_error(int job_id);
+    PackedStringArray get_job_output(int job_id);
+    double get_job_wall_time(int job_id);
+    // One analysis per result-producing command; -1 = the last one
+    int get_job_analysis_count(int job_id);
+    PackedStringArray get_job_vector_names(int job_id, int analysis = -1);
+    PackedFloat64Array get_job_vector(int job_id, const String &vector_name, int analysis = -1);
+    void release_job(int job_id);
+};
+
+} // namespace godot
+
+VARIANT_ENUM_CAST(SimWorkerPool::JobState);
+
+#endif // SIM_WORKER_POOL_H
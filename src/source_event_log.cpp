@@ -0,0 +1,188 @@
+#include "source_event_log.h"
+
+#include <cstring>
+
+static const char LOG_MAGIC[4] = { 'C', 'S', 'R', 'L' };
+static const uint32_t LOG_VERSION = 1;
+
+static bool is_little_endian() {
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
+
+// Values are stored little endian regardless of host order
+template <typename T>
+static void put(std::vector<uint8_t> &out, T value) {
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    bool little = is_little_endian();
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(bytes[little ? i : sizeof(T) - 1 - i]);
+    }
+}
+
+template <typename T>
+static bool get(const uint8_t* data, size_t size, size_t &pos, T &value) {
+    if (pos + sizeof(T) > size) {
+        return false;
+    }
+    uint8_t bytes[sizeof(T)];
+    bool little = is_little_endian();
+    for (size_t i = 0; i < sizeof(T); i++) {
+        bytes[little ? i : sizeof(T) - 1 - i] = data[pos + i];
+    }
+    memcpy(&value, bytes, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+SourceEventLog::SourceEventLog() {
+    sequence = 0;
+    cursor = 0;
+}
+
+void SourceEventLog::clear() {
+    sources.clear();
+    events.clear();
+    current.clear();
+    has_current.clear();
+    sequence = 0;
+    cursor = 0;
+}
+
+int SourceEventLog::find_source(const char *name) const {
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (strcmp(sources[i].c_str(), name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+uint32_t SourceEventLog::add_source(const char *name) {
+    int index = find_source(name);
+    if (index >= 0) {
+        return (uint32_t)index;
+    }
+    sources.push_back(name);
+    current.push_back(0.0);
+    has_current.push_back(0);
+    return (uint32_t)(sources.size() - 1);
+}
+
+void SourceEventLog::begin_recording() {
+    clear();
+}
+
+void SourceEventLog::begin_replay() {
+    sequence = 0;
+    cursor = 0;
+    current.assign(sources.size(), 0.0);
+    has_current.assign(sources.size(), 0);
+}
+
+void SourceEventLog::record(uint32_t source, double time, double value) {
+    if (!has_current[source] || current[source] != value) {
+        Event event = { time, sequence, source, value };
+        events.push_back(event);
+        current[source] = value;
+        has_current[source] = 1;
+    }
+    sequence++;
+}
+
+bool SourceEventLog::replay(uint32_t source, double &value) {
+    // Apply every change that was first seen at or before this callback
+    while (cursor < events.size() && events[cursor].sequence <= sequence) {
+        const Event &event = events[cursor++];
+        current[event.source] = event.value;
+        has_current[event.source] = 1;
+    }
+    sequence++;
+
+    if (source >= current.size() || !has_current[source]) {
+        return false;
+    }
+    value = current[source];
+    return true;
+}
+
+void SourceEventLog::serialize(std::vector<uint8_t> &out) const {
+    out.clear();
+    out.reserve(16 + sources.size() * 16 + events.size() * 28);
+
+    out.insert(out.end(), LOG_MAGIC, LOG_MAGIC + 4);
+    put<uint32_t>(out, LOG_VERSION);
+
+    put<uint32_t>(out, (uint32_t)sources.size());
+    for (const std::string &name : sources) {
+        put<uint16_t>(out, (uint16_t)name.size());
+        out.insert(out.end(), name.begin(), name.end());
+    }
+
+    put<uint64_t>(out, (uint64_t)events.size());
+    for (const Event &event : events) {
+        put<double>(out, event.time);
+        put<uint64_t>(out, event.sequence);
+        put<uint32_t>(out, event.source);
+        put<double>(out, event.value);
+    }
+}
+
+bool SourceEventLog::deserialize(const uint8_t* data, size_t size) {
+    clear();
+
+    size_t pos = 0;
+    if (size < 8 || memcmp(data, LOG_MAGIC, 4) != 0) {
+        return false;
+    }
+    pos = 4;
+
+    uint32_t version;
+    uint32_t source_count;
+    if (!get(data, size, pos, version) || version != LOG_VERSION || !get(data, size, pos, source_count)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < source_count; i++) {
+        uint16_t length;
+        if (!get(data, size, pos, length) || pos + length > size) {
+            clear();
+            return false;
+        }
+        add_source(std::string((const char*)data + pos, length).c_str());
+        pos += length;
+    }
+
+    uint64_t event_count;
+    if (!get(data, size, pos, event_count)) {
+        clear();
+        return false;
+    }
+
+    for (uint64_t i = 0; i < event_count; i++) {
+        Event event;
+        if (!get(data, size, pos, event.time) || !get(data, size, pos, event.sequence) ||
+            !get(data, size, pos, event.source) ||
+            !get(data, size, pos, event.value) || event.source >= sources.size()) {
+            clear();
+            return false;
+        }
+        events.push_back(event);
+    }
+
+    begin_replay();
+    return true;
+}
+
+size_t SourceEventLog::get_event_count() const {
+    return events.size();
+}
+
+const std::vector<SourceEventLog::Event> &SourceEventLog::get_events() const {
+    return events;
+}
+
+const std::vector<std::string> &SourceEventLog::get_sources() const {
+    return sources;
+}
@@ -0,0 +1,67 @@
+#ifndef SOURCE_EVENT_LOG_H
+#define SOURCE_EVENT_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Log of external source changes, stamped with the simulation time and the
+// index of the vsrc callback that first saw them. ngspice asks for source
+// values at trial timepoints and may step back after rejecting one, so a
+// replay keyed on simulation time alone could apply a change earlier than
+// the live run did. Replay instead applies each change at the same callback
+// index; as long as the run is identical up to that point, so is the result.
+//
+// Binary format (little endian):
+//   "CSRL" u32 version
+//   u32 source count, per source: u16 length + UTF-8 name
+//   u64 event count, per event: f64 time, u64 callback index, u32 source, f64 value
+class SourceEventLog {
+public:
+    struct Event {
+        double time;
+        uint64_t sequence;
+        uint32_t source;
+        double value;
+    };
+
+private:
+    std::vector<std::string> sources;
+    std::vector<Event> events;
+
+    // Callback counter and per-source state for recording and replay
+    uint64_t sequence;
+    size_t cursor;
+    std::vector<double> current;
+    std::vector<unsigned char> has_current;
+
+public:
+    SourceEventLog();
+
+    void clear();
+
+    // Names are C strings so the vsrc callback can look them up without
+    // building a std::string per call
+    int find_source(const char *name) const;
+    uint32_t add_source(const char *name);
+
+    // Starts a new recording or rewinds for replay
+    void begin_recording();
+    void begin_replay();
+
+    // One vsrc callback while recording; logs 'value' if it changed
+    void record(uint32_t source, double time, double value);
+
+    // One vsrc callback while replaying; false if the log never set 'source'
+    bool replay(uint32_t source, double &value);
+
+    void serialize(std::vector<uint8_t> &out) const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+    size_t get_event_count() const;
+    const std::vector<Event> &get_events() const;
+    const std::vector<std::string> &get_sources() const;
+};
+
+#endif // SOURCE_EVENT_LOG_H
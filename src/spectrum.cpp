@@ -0,0 +1,225 @@
+#include "spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+static const double PI = 3.14159265358979323846;
+
+FftPlan::FftPlan(size_t p_size) {
+    size = p_size;
+    size_t half = size / 2;
+
+    bit_reverse.resize(half);
+    int bits = 0;
+    while (((size_t)1 << bits) < half) {
+        bits++;
+    }
+    for (size_t i = 0; i < half; i++) {
+        size_t reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        bit_reverse[i] = reversed;
+    }
+
+    twiddles.resize(half / 2 > 0 ? half / 2 : 1);
+    for (size_t k = 0; k < twiddles.size(); k++) {
+        twiddles[k] = std::polar(1.0, -2.0 * PI * (double)k / (double)half);
+    }
+
+    split_twiddles.resize(half + 1);
+    for (size_t k = 0; k <= half; k++) {
+        split_twiddles[k] = std::polar(1.0, -2.0 * PI * (double)k / (double)size);
+    }
+}
+
+std::shared_ptr<const FftPlan> FftPlan::acquire(size_t size) {
+    static std::mutex cache_mutex;
+    static std::map<size_t, std::shared_ptr<const FftPlan>> cache;
+
+    if (size < 2 || !SpectrumAnalyzer::is_power_of_two(size)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    std::shared_ptr<const FftPlan> &plan = cache[size];
+    if (!plan) {
+        plan.reset(new FftPlan(size));
+    }
+    return plan;
+}
+
+void FftPlan::forward(const double *input, std::complex<double> *output,
+        std::vector<std::complex<double>> &scratch) const {
+    const size_t half = size / 2;
+    scratch.resize(half);
+    std::complex<double> *z = scratch.data();
+
+    // Pack even/odd samples as one complex sequence, in bit-reversed order
+    for (size_t i = 0; i < half; i++) {
+        size_t j = bit_reverse[i];
+        z[j] = std::complex<double>(input[2 * i], input[2 * i + 1]);
+    }
+
+    // Iterative radix-2 butterflies
+    for (size_t length = 2; length <= half; length <<= 1) {
+        size_t span = length / 2;
+        size_t stride = half / length;
+        for (size_t start = 0; start < half; start += length) {
+            for (size_t k = 0; k < span; k++) {
+                std::complex<double> t = twiddles[k * stride] * z[start + k + span];
+                std::complex<double> u = z[start + k];
+                z[start + k] = u + t;
+                z[start + k + span] = u - t;
+            }
+        }
+    }
+
+    // Split into the spectrum of the real sequence
+    for (size_t k = 0; k <= half; k++) {
+        std::complex<double> a = z[k % half];
+        std::complex<double> b = std::conj(z[(half - k) % half]);
+        std::complex<double> even = (a + b) * 0.5;
+        std::complex<double> odd = (a - b) * std::complex<double>(0.0, -0.5);
+        output[k] = even + split_twiddles[k] * odd;
+    }
+}
+
+bool SpectrumAnalyzer::is_power_of_two(size_t n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+size_t SpectrumAnalyzer::next_power_of_two(size_t n) {
+    size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+std::shared_ptr<const std::vector<double>> SpectrumAnalyzer::get_window(Window window, size_t size) {
+    static std::mutex cache_mutex;
+    static std::map<std::pair<int, size_t>, std::shared_ptr<const std::vector<double>>> cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    std::shared_ptr<const std::vector<double>> &entry = cache[std::make_pair((int)window, size)];
+    if (entry) {
+        return entry;
+    }
+
+    // Periodic windows, which is what spectral analysis wants
+    std::vector<double> *coefficients = new std::vector<double>(size, 1.0);
+    for (size_t i = 0; i < size; i++) {
+        double x = 2.0 * PI * (double)i / (double)size;
+        switch (window) {
+            case WINDOW_HANN:
+                (*coefficients)[i] = 0.5 - 0.5 * std::cos(x);
+                break;
+            case WINDOW_HAMMING:
+                (*coefficients)[i] = 0.54 - 0.46 * std::cos(x);
+                break;
+            case WINDOW_BLACKMAN:
+                (*coefficients)[i] = 0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x);
+                break;
+            case WINDOW_FLAT_TOP:
+                (*coefficients)[i] = 0.21557895 - 0.41663158 * std::cos(x) + 0.277263158 * std::cos(2.0 * x) -
+                        0.083578947 * std::cos(3.0 * x) + 0.006947368 * std::cos(4.0 * x);
+                break;
+            default:
+                break;
+        }
+    }
+    entry.reset(coefficients);
+    return entry;
+}
+
+bool SpectrumAnalyzer::resample(const double *time, const double *values, size_t count,
+        double t0, double t1, size_t points, double *out) {
+    if (count < 2 || points == 0 || !(t1 > t0)) {
+        return false;
+    }
+
+    double dt = (t1 - t0) / (double)points;
+    size_t j = 0;
+    for (size_t i = 0; i < points; i++) {
+        double t = t0 + dt * (double)i;
+        while (j + 2 < count && time[j + 1] <= t) {
+            j++;
+        }
+        double span = time[j + 1] - time[j];
+        double f = span > 0.0 ? (t - time[j]) / span : 0.0;
+        f = std::min(std::max(f, 0.0), 1.0);
+        out[i] = values[j] + (values[j + 1] - values[j]) * f;
+    }
+    return true;
+}
+
+void SpectrumAnalyzer::analyze(const double *samples, size_t size, Window window,
+        double *magnitude, double *phase) {
+    std::shared_ptr<const FftPlan> plan = FftPlan::acquire(size);
+    if (!plan) {
+        return;
+    }
+    std::shared_ptr<const std::vector<double>> coefficients = get_window(window, size);
+
+    std::vector<double> windowed(size);
+    double gain = 0.0;
+    for (size_t i = 0; i < size; i++) {
+        windowed[i] = samples[i] * (*coefficients)[i];
+        gain += (*coefficients)[i];
+    }
+
+    size_t bins = size / 2 + 1;
+    std::vector<std::complex<double>> spectrum(bins);
+    std::vector<std::complex<double>> scratch;
+    plan->forward(windowed.data(), spectrum.data(), scratch);
+
+    // DC and Nyquist have no mirror image
+    for (size_t k = 0; k < bins; k++) {
+        double scale = (k == 0 || k == bins - 1) ? 1.0 / gain : 2.0 / gain;
+        magnitude[k] = std::abs(spectrum[k]) * scale;
+        if (phase) {
+            phase[k] = std::arg(spectrum[k]);
+        }
+    }
+}
+
+size_t SpectrumAnalyzer::get_frame_count(size_t count, size_t frame_size, size_t hop) {
+    if (frame_size == 0 || hop == 0 || count < frame_size) {
+        return 0;
+    }
+    return (count - frame_size) / hop + 1;
+}
+
+void SpectrumAnalyzer::spectrogram(const double *samples, size_t count, size_t frame_size, size_t hop,
+        Window window, int threads, double *magnitude) {
+    size_t frames = get_frame_count(count, frame_size, hop);
+    if (frames == 0 || !FftPlan::acquire(frame_size)) {
+        return;
+    }
+
+    int thread_count = threads > 0 ? threads : (int)std::thread::hardware_concurrency();
+    thread_count = std::max(1, std::min(thread_count, (int)frames));
+    size_t bins = frame_size / 2 + 1;
+
+    auto worker = [&](int index) {
+        size_t begin = frames * index / thread_count;
+        size_t end = frames * (index + 1) / thread_count;
+        for (size_t f = begin; f < end; f++) {
+            analyze(samples + f * hop, frame_size, window, magnitude + f * bins, nullptr);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < thread_count; i++) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Radix-2 FFT of a real sequence, computed as a half-length complex FFT plus
+// a split step. Plans hold the bit-reversal and twiddle tables and are
+// shared: acquire() returns the cached plan for a size and is thread-safe.
+class FftPlan {
+private:
+    size_t size;
+    std::vector<size_t> bit_reverse;                 // Half-size permutation
+    std::vector<std::complex<double>> twiddles;      // Half-size transform
+    std::vector<std::complex<double>> split_twiddles; // Real split step
+
+    explicit FftPlan(size_t p_size);
+
+public:
+    static std::shared_ptr<const FftPlan> acquire(size_t size);
+
+    size_t get_size() const { return size; }
+
+    // size real inputs -> size / 2 + 1 bins. 'scratch' is per caller so
+    // one plan can be used from several threads.
+    void forward(const double *input, std::complex<double> *output,
+        std::vector<std::complex<double>> &scratch) const;
+};
+
+class SpectrumAnalyzer {
+public:
+    enum Window {
+        WINDOW_RECTANGULAR,
+        WINDOW_HANN,
+        WINDOW_HAMMING,
+        WINDOW_BLACKMAN,
+        WINDOW_FLAT_TOP,
+    };
+
+    static bool is_power_of_two(size_t n);
+    static size_t next_power_of_two(size_t n);
+
+    // Cached window coefficients
+    static std::shared_ptr<const std::vector<double>> get_window(Window window, size_t size);
+
+    // Linear interpolation of (time, values) onto 'points' samples starting
+    // at t0 with spacing (t1 - t0) / points
+    static bool resample(const double *time, const double *values, size_t count,
+        double t0, double t1, size_t points, double *out);
+
+    // Single-sided amplitude spectrum (a sine of amplitude A at a bin
+    // frequency reads A) and phase in radians, size / 2 + 1 bins each.
+    // 'phase' may be null.
+    static void analyze(const double *samples, size_t size, Window window,
+        double *magnitude, double *phase);
+
+    // Magnitudes of frames of 'frame_size' samples every 'hop' samples,
+    // row-major [frame][bin]; frames are split across threads (0 = all cores)
+    static size_t get_frame_count(size_t count, size_t frame_size, size_t hop);
+    static void spectrogram(const double *samples, size_t count, size_t frame_size, size_t hop,
+        Window window, int threads, double *magnitude);
+};
+
+#endif // SPECTRUM_H
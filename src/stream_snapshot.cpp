@@ -0,0 +1,160 @@
+#include "stream_snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+StreamSnapshot::StreamSnapshot(const std::shared_ptr<const Layout> &p_layout,
+        const std::shared_ptr<const Directory> &p_directory, size_t p_rows) :
+        layout(p_layout),
+        directory(p_directory),
+        rows(p_rows) {
+}
+
+int StreamSnapshot::find_column(const std::string &key) const {
+    for (size_t i = 0; i < layout->keys.size(); i++) {
+        if (layout->keys[i] == key) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+double StreamSnapshot::get_value(int column, size_t row) const {
+    const double *block = directory->blocks[row / BLOCK_ROWS].get();
+    return block[(size_t)column * BLOCK_ROWS + row % BLOCK_ROWS];
+}
+
+void StreamSnapshot::copy_column(int column, size_t begin, size_t end, double *out) const {
+    end = std::min(end, rows);
+    while (begin < end) {
+        size_t offset = begin % BLOCK_ROWS;
+        size_t count = std::min(BLOCK_ROWS - offset, end - begin);
+        const double *block = directory->blocks[begin / BLOCK_ROWS].get();
+        memcpy(out, block + (size_t)column * BLOCK_ROWS + offset, count * sizeof(double));
+        out += count;
+        begin += count;
+    }
+}
+
+size_t StreamSnapshot::count_rows_until(double time) const {
+    size_t lo = 0;
+    size_t hi = rows;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (get_value(layout->scale, mid) <= time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t StreamSnapshot::count_rows_before(double time) const {
+    size_t lo = 0;
+    size_t hi = rows;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (get_value(layout->scale, mid) < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+std::shared_ptr<const StreamSnapshot> StreamSnapshot::truncated(size_t p_rows) const {
+    return std::make_shared<const StreamSnapshot>(layout, directory, std::min(p_rows, rows));
+}
+
+SnapshotPublisher::SnapshotPublisher() :
+        published_rows(0) {
+    block_count = 0;
+    tail = nullptr;
+    rows = 0;
+}
+
+void SnapshotPublisher::reset(const std::vector<std::string> &names, const std::vector<std::string> &keys, int scale,
+        uint64_t generation) {
+    // The count drops first, so a reader never pairs the old count with the
+    // new layout. Earlier snapshots keep their own layout and blocks.
+    published_rows.store(0, std::memory_order_release);
+    layout = std::make_shared<StreamSnapshot::Layout>();
+    layout->names = names;
+    layout->keys = keys;
+    layout->scale = scale;
+    layout->generation = generation;
+    directory = std::make_shared<StreamSnapshot::Directory>();
+    directory->blocks.resize(16);
+    block_count = 0;
+    tail = nullptr;
+    rows = 0;
+    publish_base();
+}
+
+void SnapshotPublisher::clear() {
+    published_rows.store(0, std::memory_order_release);
+    layout.reset();
+    directory.reset();
+    block_count = 0;
+    tail = nullptr;
+    rows = 0;
+    std::atomic_store(&base, std::shared_ptr<const StreamSnapshot>());
+}
+
+void SnapshotPublisher::publish_base() {
+    size_t capacity = directory->blocks.size() * StreamSnapshot::BLOCK_ROWS;
+    std::atomic_store(&base, std::shared_ptr<const StreamSnapshot>(
+        std::make_shared<const StreamSnapshot>(layout, directory, capacity)));
+}
+
+void SnapshotPublisher::append(const double *row) {
+    if (!layout) {
+        return;
+    }
+
+    const size_t columns = layout->names.size();
+    const size_t offset = rows % StreamSnapshot::BLOCK_ROWS;
+    if (offset == 0) {
+        if (block_count == directory->blocks.size()) {
+            // Published before any row needs it, so a count past the old
+            // capacity is never paired with the old directory
+            std::shared_ptr<StreamSnapshot::Directory> grown = std::make_shared<StreamSnapshot::Directory>();
+            grown->blocks.resize(block_count * 2);
+            std::copy(directory->blocks.begin(), directory->blocks.end(), grown->blocks.begin());
+            directory = grown;
+            publish_base();
+        }
+        std::shared_ptr<double> block(new double[std::max<size_t>(columns, 1) * StreamSnapshot::BLOCK_ROWS],
+            std::default_delete<double[]>());
+        tail = block.get();
+        directory->blocks[block_count++] = block;
+    }
+
+    for (size_t c = 0; c < columns; c++) {
+        tail[c * StreamSnapshot::BLOCK_ROWS + offset] = row[c];
+    }
+    rows++;
+}
+
+void SnapshotPublisher::publish() {
+    if (!layout) {
+        return;
+    }
+    published_rows.store(rows, std::memory_order_release);
+}
+
+std::shared_ptr<const StreamSnapshot> SnapshotPublisher::acquire() const {
+    // A count read between two loads of the same base belongs to it: reset()
+    // drops the count before swapping the base, and growth swaps the base
+    // before the count passes the old capacity
+    for (;;) {
+        std::shared_ptr<const StreamSnapshot> current = std::atomic_load(&base);
+        size_t count = published_rows.load(std::memory_order_acquire);
+        if (std::atomic_load(&base) == current) {
+            return current ? current->truncated(count) : current;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef STREAM_SNAPSHOT_H
+#define STREAM_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Streamed rows stored in fixed blocks of BLOCK_ROWS rows (column-major
+// inside a block). Blocks are only ever appended to, and a row is written
+// before the snapshot that covers it is published, so readers never see a
+// value change. A snapshot is a row count plus shared pointers to the
+// block directory, so publishing one copies no sample data.
+class StreamSnapshot {
+public:
+    static const size_t BLOCK_ROWS = 1024;
+
+    struct Layout {
+        std::vector<std::string> names;
+        std::vector<std::string> keys;  // Lookup keys (see CircuitSimulator::probe_key)
+        int scale;
+        uint64_t generation;
+    };
+
+    // Fixed-capacity list of blocks. Entries past a snapshot's rows are
+    // filled in later by the producer; a full directory is replaced by a
+    // larger copy, and older snapshots keep the old one alive.
+    struct Directory {
+        std::vector<std::shared_ptr<double>> blocks;
+    };
+
+private:
+    std::shared_ptr<const Layout> layout;
+    std::shared_ptr<const Directory> directory;
+    size_t rows;
+
+public:
+    StreamSnapshot(const std::shared_ptr<const Layout> &p_layout, const std::shared_ptr<const Directory> &p_directory,
+        size_t p_rows);
+
+    const Layout &get_layout() const { return *layout; }
+    size_t get_row_count() const { return rows; }
+    size_t get_column_count() const { return layout->names.size(); }
+
+    int find_column(const std::string &key) const;
+    double get_value(int column, size_t row) const;
+    void copy_column(int column, size_t begin, size_t end, double *out) const;
+
+    // Rows with a scale value <= time, or < time (binary searches over the
+    // scale column)
+    size_t count_rows_until(double time) const;
+    size_t count_rows_before(double time) const;
+
+    // Same data, first 'p_rows' rows only
+    std::shared_ptr<const StreamSnapshot> truncated(size_t p_rows) const;
+};
+
+// Producer side. append() and reset() run on the streaming thread (the
+// caller serializes them); acquire() may be called from any thread and
+// never waits for the producer.
+//
+// Publishing a row only stores the row count. The shared snapshot object
+// (layout plus directory) is replaced on reset() and when the directory
+// grows, so the producer allocates once per BLOCK_ROWS rows, not per row;
+// acquire() pairs the count with the snapshot it belongs to.
+class SnapshotPublisher {
+private:
+    std::shared_ptr<StreamSnapshot::Layout> layout;
+    std::shared_ptr<StreamSnapshot::Directory> directory;
+    size_t block_count;
+    double *tail;
+    size_t rows;
+
+    // 'base' covers the whole directory and is accessed only through
+    // std::atomic_load / std::atomic_store
+    std::shared_ptr<const StreamSnapshot> base;
+    std::atomic<size_t> published_rows;
+    void publish_base();
+
+public:
+    SnapshotPublisher();
+
+    void reset(const std::vector<std::string> &names, const std::vector<std::string> &keys, int scale,
+        uint64_t generation);
+    void clear();
+
+    void append(const double *row);
+    void publish();
+
+    std::shared_ptr<const StreamSnapshot> acquire() const;
+};
+
+#endif // STREAM_SNAPSHOT_H
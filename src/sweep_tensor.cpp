@@ -0,0 +1,214 @@
+#include "sweep_tensor.h"
+
+#include <godot_cpp/variant/utility_functions.hpp>
+
+using namespace godot;
+
+void SweepTensor::_bind_methods() {
+    ClassDB::bind_method(D_METHOD("get_rank"), &SweepTensor::get_rank);
+    ClassDB::bind_method(D_METHOD("get_shape"), &SweepTensor::get_shape);
+    ClassDB::bind_method(D_METHOD("get_strides"), &SweepTensor::get_strides);
+    ClassDB::bind_method(D_METHOD("get_size"), &SweepTensor::get_size);
+    ClassDB::bind_method(D_METHOD("get_offset"), &SweepTensor::get_offset);
+    ClassDB::bind_method(D_METHOD("is_contiguous"), &SweepTensor::is_contiguous);
+
+    ClassDB::bind_method(D_METHOD("get_axis_names"), &SweepTensor::get_axis_names);
+    ClassDB::bind_method(D_METHOD("find_axis", "name"), &SweepTensor::find_axis);
+    ClassDB::bind_method(D_METHOD("get_axis_values", "axis"), &SweepTensor::get_axis_values);
+    ClassDB::bind_method(D_METHOD("get_axis_labels", "axis"), &SweepTensor::get_axis_labels);
+
+    ClassDB::bind_method(D_METHOD("get_value", "indices"), &SweepTensor::get_value);
+    ClassDB::bind_method(D_METHOD("slice", "axis", "index"), &SweepTensor::slice);
+    ClassDB::bind_method(D_METHOD("narrow", "axis", "start", "count"), &SweepTensor::narrow);
+    ClassDB::bind_method(D_METHOD("get_buffer"), &SweepTensor::get_buffer);
+    ClassDB::bind_method(D_METHOD("to_packed"), &SweepTensor::to_packed);
+}
+
+SweepTensor::SweepTensor() {
+    offset = 0;
+}
+
+void SweepTensor::setup(const PackedFloat64Array &buffer, const std::vector<int64_t> &tensor_shape,
+        const PackedStringArray &names, const Array &values, const Array &labels) {
+    data = buffer;
+    offset = 0;
+    shape = tensor_shape;
+    strides.assign(shape.size(), 1);
+    for (int i = (int)shape.size() - 2; i >= 0; i--) {
+        strides[i] = strides[i + 1] * shape[i + 1];
+    }
+    axis_names = names;
+    axis_values = values;
+    axis_labels = labels;
+}
+
+Ref<SweepTensor> SweepTensor::make_view(int64_t view_offset, const std::vector<int> &keep_axes,
+        const std::vector<int64_t> &view_shape) const {
+    Ref<SweepTensor> view;
+    view.instantiate();
+    view->data = data;
+    view->offset = view_offset;
+
+    for (size_t i = 0; i < keep_axes.size(); i++) {
+        int axis = keep_axes[i];
+        view->shape.push_back(view_shape[i]);
+        view->strides.push_back(strides[axis]);
+        view->axis_names.append(axis_names[axis]);
+        view->axis_values.append(axis_values[axis]);
+        view->axis_labels.append(axis_labels[axis]);
+    }
+    return view;
+}
+
+int SweepTensor::get_rank() const {
+    return (int)shape.size();
+}
+
+PackedInt64Array SweepTensor::get_shape() const {
+    PackedInt64Array result;
+    for (int64_t extent : shape) {
+        result.append(extent);
+    }
+    return result;
+}
+
+PackedInt64Array SweepTensor::get_strides() const {
+    PackedInt64Array result;
+    for (int64_t stride : strides) {
+        result.append(stride);
+    }
+    return result;
+}
+
+int64_t SweepTensor::get_size() const {
+    int64_t size = 1;
+    for (int64_t extent : shape) {
+        size *= extent;
+    }
+    return size;
+}
+
+int64_t SweepTensor::get_offset() const {
+    return offset;
+}
+
+bool SweepTensor::is_contiguous() const {
+    int64_t expected = 1;
+    for (int i = (int)shape.size() - 1; i >= 0; i--) {
+        if (shape[i] != 1 && strides[i] != expected) {
+            return false;
+        }
+        expected *= shape[i];
+    }
+    return true;
+}
+
+PackedStringArray SweepTensor::get_axis_names() const {
+    return axis_names;
+}
+
+int SweepTensor::find_axis(const String &name) const {
+    for (int i = 0; i < axis_names.size(); i++) {
+        if (axis_names[i] == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+PackedFloat64Array SweepTensor::get_axis_values(int axis) const {
+    ERR_FAIL_INDEX_V(axis, (int)shape.size(), PackedFloat64Array());
+    return axis_values[axis];
+}
+
+PackedStringArray SweepTensor::get_axis_labels(int axis) const {
+    ERR_FAIL_INDEX_V(axis, (int)shape.size(), PackedStringArray());
+    return axis_labels[axis];
+}
+
+double SweepTensor::get_value(const PackedInt64Array &indices) const {
+    ERR_FAIL_COND_V_MSG(indices.size() != (int64_t)shape.size(), 0.0, "Index count does not match tensor rank");
+
+    int64_t position = offset;
+    for (size_t i = 0; i < shape.size(); i++) {
+        int64_t index = indices[i];
+        ERR_FAIL_INDEX_V(index, shape[i], 0.0);
+        position += index * strides[i];
+    }
+    return data[position];
+}
+
+Ref<SweepTensor> SweepTensor::slice(int axis, int64_t index) const {
+    ERR_FAIL_INDEX_V(axis, (int)shape.size(), Ref<SweepTensor>());
+    ERR_FAIL_INDEX_V(index, shape[axis], Ref<SweepTensor>());
+
+    std::vector<int> keep_axes;
+    std::vector<int64_t> view_shape;
+    for (int i = 0; i < (int)shape.size(); i++) {
+        if (i != axis) {
+            keep_axes.push_back(i);
+            view_shape.push_back(shape[i]);
+        }
+    }
+    return make_view(offset + index * strides[axis], keep_axes, view_shape);
+}
+
+Ref<SweepTensor> SweepTensor::narrow(int axis, int64_t start, int64_t count) const {
+    ERR_FAIL_INDEX_V(axis, (int)shape.size(), Ref<SweepTensor>());
+    ERR_FAIL_COND_V_MSG(start < 0 || count < 1 || start + count > shape[axis], Ref<SweepTensor>(), "Range outside axis");
+
+    std::vector<int> keep_axes;
+    std::vector<int64_t> view_shape = shape;
+    for (int i = 0; i < (int)shape.size(); i++) {
+        keep_axes.push_back(i);
+    }
+    view_shape[axis] = count;
+
+    Ref<SweepTensor> view = make_view(offset + start * strides[axis], keep_axes, view_shape);
+
+    // Keep the coordinates in step with the narrowed axis
+    PackedFloat64Array values = axis_values[axis];
+    if (values.size() >= start + count) {
+        view->axis_values[axis] = values.slice(start, start + count);
+    }
+    PackedStringArray labels = axis_labels[axis];
+    if (labels.size() >= start + count) {
+        view->axis_labels[axis] = labels.slice(start, start + count);
+    }
+    return view;
+}
+
+PackedFloat64Array SweepTensor::get_buffer() const {
+    return data;
+}
+
+PackedFloat64Array SweepTensor::to_packed() const {
+    int64_t size = get_size();
+    if (offset == 0 && size == data.size() && is_contiguous()) {
+        return data;
+    }
+
+    PackedFloat64Array result;
+    result.resize(size);
+    if (size == 0) {
+        return result;
+    }
+
+    // Odometer over the view's indices
+    double *dst = result.ptrw();
+    const double *src = data.ptr();
+    std::vector<int64_t> index(shape.size(), 0);
+    int64_t position = offset;
+    for (int64_t n = 0; n < size; n++) {
+        dst[n] = src[position];
+        for (int axis = (int)shape.size() - 1; axis >= 0; axis--) {
+            position += strides[axis];
+            if (++index[axis] < shape[axis]) {
+                break;
+            }
+            position -= strides[axis] * shape[axis];
+            index[axis] = 0;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,71 @@
+#ifndef SWEEP_TENSOR_H
+#define SWEEP_TENSOR_H
+
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/array.hpp>
+#include <godot_cpp/variant/string.hpp>
+
+#include <vector>
+
+namespace godot {
+
+// Strided view over one contiguous packed buffer of sweep results, with
+// names, values and labels per axis. Slicing returns a new view sharing the
+// same buffer (PackedFloat64Array is copy-on-write), so no samples are copied.
+class SweepTensor : public RefCounted {
+    GDCLASS(SweepTensor, RefCounted)
+
+private:
+    PackedFloat64Array data;
+    int64_t offset;
+    std::vector<int64_t> shape;
+    std::vector<int64_t> strides;
+
+    // Per axis: name, numeric coordinates and/or string labels
+    PackedStringArray axis_names;
+    Array axis_values;
+    Array axis_labels;
+
+    Ref<SweepTensor> make_view(int64_t view_offset, const std::vector<int> &keep_axes,
+        const std::vector<int64_t> &view_shape) const;
+
+protected:
+    static void _bind_methods();
+
+public:
+    SweepTensor();
+
+    // Contiguous row-major tensor over 'buffer'
+    void setup(const PackedFloat64Array &buffer, const std::vector<int64_t> &tensor_shape,
+        const PackedStringArray &names, const Array &values, const Array &labels);
+
+    int get_rank() const;
+    PackedInt64Array get_shape() const;
+    PackedInt64Array get_strides() const;
+    int64_t get_size() const;
+    int64_t get_offset() const;
+    bool is_contiguous() const;
+
+    PackedStringArray get_axis_names() const;
+    int find_axis(const String &name) const;
+    PackedFloat64Array get_axis_values(int axis) const;
+    PackedStringArray get_axis_labels(int axis) const;
+
+    double get_value(const PackedInt64Array &indices) const;
+
+    // Views (zero-copy)
+    Ref<SweepTensor> slice(int axis, int64_t index) const;
+    Ref<SweepTensor> narrow(int axis, int64_t start, int64_t count) const;
+
+    // Raw buffer for zero-copy consumers: element i of a view lives at
+    // offset + sum(index[k] * strides[k])
+    PackedFloat64Array get_buffer() const;
+
+    // Contiguous copy of the view (no copy if the view is the whole buffer)
+    PackedFloat64Array to_packed() const;
+};
+
+} // namespace godot
+
+#endif // SWEEP_TENSOR_H
@@ -0,0 +1,227 @@
+#include "waveform_compare.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+// Independent accumulators per lane, so the reductions need no
+// reassociation and vectorize without fast-math
+static const size_t LANES = 32;
+
+WaveformCompare::Settings::Settings() {
+    absolute = 1e-3;
+    relative = 0.0;
+    t0 = 0.0;
+    t1 = -1.0;
+}
+
+WaveformCompare::Result::Result() {
+    valid = false;
+    passed = false;
+    points = 0;
+    coverage = 0.0;
+    t0 = 0.0;
+    t1 = 0.0;
+    max_error = 0.0;
+    max_error_time = 0.0;
+    rms_error = 0.0;
+    violations = 0;
+    first_fail_time = -1.0;
+}
+
+void WaveformCompare::interpolate(const double *t, const double *v, size_t n, const double *x, size_t count, double *out) {
+    size_t k = 0;
+    for (size_t i = 0; i < count; i++) {
+        while (k < n && t[k] < x[i]) {
+            k++;
+        }
+        if (k == 0) {
+            out[i] = v[0];
+        } else if (k == n) {
+            out[i] = v[n - 1];
+        } else {
+            double dt = t[k] - t[k - 1];
+            out[i] = dt > 0.0 ? v[k - 1] + (v[k] - v[k - 1]) * ((x[i] - t[k - 1]) / dt) : v[k];
+        }
+    }
+}
+
+// Union of both time bases inside [lo, hi], without duplicates
+static void merge_times(const double *a, size_t na, const double *b, size_t nb, double lo, double hi,
+        std::vector<double> &out) {
+    out.clear();
+    out.push_back(lo);
+    size_t i = std::upper_bound(a, a + na, lo) - a;
+    size_t j = std::upper_bound(b, b + nb, lo) - b;
+    while (i < na || j < nb) {
+        double next;
+        if (j >= nb || (i < na && a[i] <= b[j])) {
+            next = a[i++];
+        } else {
+            next = b[j++];
+        }
+        if (next >= hi) {
+            break;
+        }
+        if (next > out.back()) {
+            out.push_back(next);
+        }
+    }
+    if (hi > out.back()) {
+        out.push_back(hi);
+    }
+}
+
+WaveformCompare::Result WaveformCompare::compare(const Pair &pair, const Settings &settings, Scratch &scratch) {
+    Result result;
+    if (pair.reference_count == 0 || pair.count == 0) {
+        return result;
+    }
+
+    // Required: the reference from t0 to t1 (or its end). A run that
+    // stopped early is compared on what exists but cannot pass.
+    double required_lo = std::max(pair.reference_time[0], settings.t0);
+    double required_hi = settings.t1 >= 0.0 ? settings.t1 : pair.reference_time[pair.reference_count - 1];
+    double lo = std::max(required_lo, pair.time[0]);
+    double hi = std::min(std::min(pair.reference_time[pair.reference_count - 1], pair.time[pair.count - 1]), required_hi);
+    if (!(hi >= lo)) {
+        return result;
+    }
+    result.coverage = required_hi > required_lo ? std::min(1.0, (hi - lo) / (required_hi - required_lo)) : 1.0;
+
+    merge_times(pair.reference_time, pair.reference_count, pair.time, pair.count, lo, hi, scratch.time);
+    const size_t n = scratch.time.size();
+    scratch.reference.resize(n);
+    scratch.values.resize(n);
+    scratch.weights.resize(n);
+    const double *t = scratch.time.data();
+    interpolate(pair.reference_time, pair.reference, pair.reference_count, t, n, scratch.reference.data());
+    interpolate(pair.time, pair.values, pair.count, t, n, scratch.values.data());
+
+    // Trapezoid weights, so densely stepped regions do not dominate the RMS
+    double *w = scratch.weights.data();
+    if (n == 1) {
+        w[0] = 1.0;
+    } else {
+        w[0] = 0.5 * (t[1] - t[0]);
+        for (size_t i = 1; i + 1 < n; i++) {
+            w[i] = 0.5 * (t[i + 1] - t[i - 1]);
+        }
+        w[n - 1] = 0.5 * (t[n - 1] - t[n - 2]);
+    }
+
+    // Error pass: only min/max/add per sample, no compares or branches.
+    // std::max drops NaN, so non-finite samples are caught by d - d, which
+    // is NaN for them and sticks in the lane sum.
+    const double *r = scratch.reference.data();
+    const double *s = scratch.values.data();
+    const double absolute = settings.absolute;
+    const double relative = settings.relative;
+
+    double max_error[LANES];
+    double max_excess[LANES];
+    double sum_sq[LANES];
+    double nonfinite[LANES];
+    for (size_t l = 0; l < LANES; l++) {
+        max_error[l] = 0.0;
+        max_excess[l] = -std::numeric_limits<double>::infinity();
+        sum_sq[l] = 0.0;
+        nonfinite[l] = 0.0;
+    }
+    const size_t blocks = n / LANES * LANES;
+    for (size_t b = 0; b < blocks; b += LANES) {
+        for (size_t l = 0; l < LANES; l++) {
+            double d = std::fabs(s[b + l] - r[b + l]);
+            double e = d - (absolute + relative * std::fabs(r[b + l]));
+            max_error[l] = std::max(d, max_error[l]);
+            max_excess[l] = std::max(e, max_excess[l]);
+            sum_sq[l] += w[b + l] * d * d;
+            nonfinite[l] += d - d;
+        }
+    }
+    for (size_t i = blocks; i < n; i++) {
+        double d = std::fabs(s[i] - r[i]);
+        double e = d - (absolute + relative * std::fabs(r[i]));
+        max_error[0] = std::max(d, max_error[0]);
+        max_excess[0] = std::max(e, max_excess[0]);
+        sum_sq[0] += w[i] * d * d;
+        nonfinite[0] += d - d;
+    }
+
+    double worst = 0.0;
+    double worst_excess = -std::numeric_limits<double>::infinity();
+    double total = 0.0;
+    double bad = 0.0;
+    for (size_t l = 0; l < LANES; l++) {
+        worst = std::max(worst, max_error[l]);
+        worst_excess = std::max(worst_excess, max_excess[l]);
+        total += sum_sq[l];
+        bad += nonfinite[l];
+    }
+    bool has_nonfinite = std::isnan(bad);
+
+    result.valid = true;
+    result.points = n;
+    result.t0 = lo;
+    result.t1 = hi;
+    result.max_error = has_nonfinite ? std::numeric_limits<double>::infinity() : worst;
+    result.rms_error = has_nonfinite ? std::numeric_limits<double>::infinity()
+        : (n == 1 ? worst : std::sqrt(total / (hi - lo)));
+    for (size_t i = 0; i < n; i++) {
+        double d = std::fabs(s[i] - r[i]);
+        if (has_nonfinite ? !std::isfinite(d) : d == worst) {
+            result.max_error_time = t[i];
+            break;
+        }
+    }
+
+    // Slow path, only for failing pairs. !(e <= 0) also catches NaN.
+    if (worst_excess > 0.0 || has_nonfinite) {
+        double previous = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            double e = std::fabs(s[i] - r[i]) - (absolute + relative * std::fabs(r[i]));
+            if (!(e <= 0.0)) {
+                if (result.violations == 0) {
+                    // Crossing of the band edge between the previous sample and this one
+                    double f = (i > 0 && previous < 0.0) ? -previous / (e - previous) : 0.0;
+                    result.first_fail_time = (i > 0 && std::isfinite(e)) ? t[i - 1] + (t[i] - t[i - 1]) * f : t[i];
+                }
+                result.violations++;
+            }
+            previous = e;
+        }
+    }
+
+    // Endpoints may differ by rounding, not by a missing step
+    bool covered = result.coverage >= 1.0 - 1e-9;
+    if (!covered && result.first_fail_time < 0.0) {
+        result.first_fail_time = hi;
+    }
+    result.passed = result.violations == 0 && covered;
+    return result;
+}
+
+void WaveformCompare::compare_batch(const std::vector<Pair> &pairs, const Settings &settings,
+        std::vector<Result> &results, int thread_count) {
+    results.assign(pairs.size(), Result());
+    if (thread_count <= 0) {
+        thread_count = (int)std::thread::hardware_concurrency();
+    }
+    thread_count = std::max(1, std::min(thread_count, (int)pairs.size()));
+
+    auto worker = [&](int index) {
+        Scratch scratch;
+        for (size_t i = index; i < pairs.size(); i += thread_count) {
+            results[i] = compare(pairs[i], settings, scratch);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_count; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef WAVEFORM_COMPARE_H
+#define WAVEFORM_COMPARE_H
+
+#include <cstddef>
+#include <vector>
+
+// Compares a waveform against a reference when the two come from runs with
+// different adaptive time bases. Both are interpolated onto the union of
+// their timepoints (within the common time range), so a spike in either
+// one lands on a sample. The error pass itself is branch-free and
+// vectorizes; tolerance violations are only located when there are any.
+// Non-finite samples count as violations, and a pair only passes when
+// both waveforms span the whole required range.
+class WaveformCompare {
+public:
+    struct Settings {
+        double absolute;   // Allowed |error| ...
+        double relative;   // ... plus this fraction of |reference|
+        double t0;
+        double t1;         // < 0 = end of the reference
+
+        Settings();
+    };
+
+    struct Pair {
+        const double *reference_time;
+        const double *reference;
+        size_t reference_count;
+        const double *time;
+        const double *values;
+        size_t count;
+    };
+
+    struct Result {
+        bool valid;             // False if the waveforms do not overlap
+        bool passed;
+        size_t points;          // Samples on the merged time base
+        double coverage;        // Share of the required range both waveforms span
+        double t0;
+        double t1;
+        double max_error;
+        double max_error_time;
+        double rms_error;       // Time-weighted over [t0, t1]
+        size_t violations;      // Samples outside the tolerance band
+        double first_fail_time; // Where the error first leaves the band, -1 if never
+
+        Result();
+    };
+
+    // Per-thread buffers, reused between pairs
+    struct Scratch {
+        std::vector<double> time;
+        std::vector<double> reference;
+        std::vector<double> values;
+        std::vector<double> weights;
+    };
+
+    static Result compare(const Pair &pair, const Settings &settings, Scratch &scratch);
+
+    // thread_count 0 = one per core
+    static void compare_batch(const std::vector<Pair> &pairs, const Settings &settings,
+        std::vector<Result> &results, int thread_count = 0);
+
+    // Linear interpolation of (t, v) at the sorted times x, clamped at the ends
+    static void interpolate(const double *t, const double *v, size_t n, const double *x, size_t count, double *out);
+};
+
+#endif // WAVEFORM_COMPARE_H
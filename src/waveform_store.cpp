@@ -0,0 +1,388 @@
+#include "waveform_store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static int count_leading_zeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - (int)index;
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+static int count_trailing_zeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+static uint64_t double_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bits_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+BitWriter::BitWriter() {
+    words = nullptr;
+    bit_count = 0;
+}
+
+void BitWriter::start(uint64_t* p_words) {
+    words = p_words;
+    bit_count = 0;
+}
+
+void BitWriter::write(uint64_t value, int bits) {
+    if (bits <= 0) {
+        return;
+    }
+    if (bits < 64) {
+        value &= (uint64_t(1) << bits) - 1;
+    }
+
+    size_t index = bit_count >> 6;
+    int offset = (int)(bit_count & 63);
+    if (offset == 0) {
+        words[index] = 0;
+    }
+
+    int free_bits = 64 - offset;
+    if (bits <= free_bits) {
+        words[index] |= value << (free_bits - bits);
+    } else {
+        int rest = bits - free_bits;
+        words[index] |= value >> rest;
+        words[index + 1] = value << (64 - rest);
+    }
+    bit_count += bits;
+}
+
+size_t BitWriter::get_bit_count() const {
+    return bit_count;
+}
+
+size_t BitWriter::get_word_count() const {
+    return (bit_count + 63) >> 6;
+}
+
+const uint64_t* BitWriter::get_words() const {
+    return words;
+}
+
+BitReader::BitReader(const uint64_t* p_words) {
+    words = p_words;
+    position = 0;
+}
+
+uint64_t BitReader::read(int bits) {
+    size_t index = position >> 6;
+    int offset = (int)(position & 63);
+    int free_bits = 64 - offset;
+    position += bits;
+
+    if (bits <= free_bits) {
+        return (words[index] << offset) >> (64 - bits);
+    }
+
+    int rest = bits - free_bits;
+    uint64_t high = words[index] & ((uint64_t(1) << free_bits) - 1);
+    return (high << rest) | (words[index + 1] >> (64 - rest));
+}
+
+bool BitReader::read_bit() {
+    return read(1) != 0;
+}
+
+WaveformStore::WaveformStore() {
+    scale_index = -1;
+    sample_count = 0;
+    compressed_words = 0;
+    scratch_columns = nullptr;
+    last_decode_seconds = 0.0;
+    last_decode_samples = 0;
+}
+
+void WaveformStore::reset(const std::vector<std::string> &vector_names, int scale) {
+    names = vector_names;
+    scale_index = scale;
+    blocks.clear();
+    sample_count = 0;
+    compressed_words = 0;
+
+    // One scratch buffer per column for the open block
+    arena.reset();
+    encoders.resize(names.size());
+    scratch_columns = arena.allocate_array<const uint64_t*>(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        encoders[i].scratch = arena.allocate_array<uint64_t>(MAX_BLOCK_WORDS);
+        encoders[i].bits.start(encoders[i].scratch);
+        scratch_columns[i] = encoders[i].scratch;
+    }
+}
+
+void WaveformStore::clear() {
+    reset(std::vector<std::string>(), -1);
+}
+
+bool WaveformStore::is_configured() const {
+    return scale_index >= 0 && !names.empty();
+}
+
+void WaveformStore::encode_scale(ColumnEncoder &column, uint64_t bits, bool first) {
+    if (first) {
+        column.bits.write(bits, 64);
+        column.previous = bits;
+        column.previous_delta = 0;
+        return;
+    }
+
+    // Delta-of-delta of the bit patterns is exact in integer arithmetic,
+    // and small for the near-regular steps of a transient run
+    int64_t delta = (int64_t)(bits - column.previous);
+    int64_t dod = delta - column.previous_delta;
+    uint64_t zigzag = ((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63);
+    column.previous = bits;
+    column.previous_delta = delta;
+
+    if (zigzag == 0) {
+        column.bits.write(0x0, 1);
+    } else if (zigzag < (uint64_t(1) << 7)) {
+        column.bits.write(0x2, 2);
+        column.bits.write(zigzag, 7);
+    } else if (zigzag < (uint64_t(1) << 12)) {
+        column.bits.write(0x6, 3);
+        column.bits.write(zigzag, 12);
+    } else if (zigzag < (uint64_t(1) << 20)) {
+        column.bits.write(0xe, 4);
+        column.bits.write(zigzag, 20);
+    } else if (zigzag < (uint64_t(1) << 32)) {
+        column.bits.write(0x1e, 5);
+        column.bits.write(zigzag, 32);
+    } else {
+        column.bits.write(0x1f, 5);
+        column.bits.write(zigzag, 64);
+    }
+}
+
+void WaveformStore::encode_value(ColumnEncoder &column, uint64_t bits, bool first) {
+    if (first) {
+        column.bits.write(bits, 64);
+        column.previous = bits;
+        column.leading = -1;
+        column.trailing = 0;
+        return;
+    }
+
+    uint64_t x = bits ^ column.previous;
+    column.previous = bits;
+    if (x == 0) {
+        column.bits.write(0x0, 1);
+        return;
+    }
+
+    int leading = std::min(count_leading_zeros(x), 31);
+    int trailing = count_trailing_zeros(x);
+
+    if (column.leading >= 0 && leading >= column.leading && trailing >= column.trailing) {
+        // Meaningful bits fit in the previous window
+        int meaningful = 64 - column.leading - column.trailing;
+        column.bits.write(0x2, 2);
+        column.bits.write(x >> column.trailing, meaningful);
+    } else {
+        int meaningful = 64 - leading - trailing;
+        column.bits.write(0x3, 2);
+        column.bits.write((uint64_t)leading, 5);
+        column.bits.write((uint64_t)(meaningful - 1), 6);
+        column.bits.write(x >> trailing, meaningful);
+        column.leading = leading;
+        column.trailing = trailing;
+    }
+}
+
+void WaveformStore::append_row(const double* values) {
+    if (!is_configured()) {
+        return;
+    }
+
+    if (blocks.empty() || blocks.back().count == BLOCK_SIZE) {
+        Block block;
+        block.first_sample = sample_count;
+        block.count = 0;
+        block.scale_first = values[scale_index];
+        block.scale_last = values[scale_index];
+        block.columns = scratch_columns;
+        blocks.push_back(block);
+    }
+
+    Block &block = blocks.back();
+    bool first = block.count == 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        uint64_t bits = double_bits(values[i]);
+        if (first) {
+            encoders[i].bits.start(encoders[i].scratch);
+        }
+        if ((int)i == scale_index) {
+            encode_scale(encoders[i], bits, first);
+        } else {
+            encode_value(encoders[i], bits, first);
+        }
+    }
+
+    block.scale_last = values[scale_index];
+    block.count++;
+    sample_count++;
+
+    if (block.count == BLOCK_SIZE) {
+        close_block(block);
+    }
+}
+
+void WaveformStore::close_block(Block &block) {
+    // Full blocks never grow again; keep only the words they use
+    const uint64_t** columns = arena.allocate_array<const uint64_t*>(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        size_t count = encoders[i].bits.get_word_count();
+        uint64_t* words = arena.allocate_array<uint64_t>(count);
+        memcpy(words, encoders[i].bits.get_words(), count * sizeof(uint64_t));
+        columns[i] = words;
+        compressed_words += count;
+    }
+    block.columns = columns;
+}
+
+void WaveformStore::decode_block(const Block &block, int column, std::vector<double> &out) const {
+    BitReader reader(block.columns[column]);
+
+    uint64_t previous = reader.read(64);
+    out.push_back(bits_double(previous));
+
+    if (column == scale_index) {
+        int64_t delta = 0;
+        for (uint32_t i = 1; i < block.count; i++) {
+            uint64_t zigzag = 0;
+            if (reader.read_bit()) {
+                if (!reader.read_bit()) {
+                    zigzag = reader.read(7);
+                } else if (!reader.read_bit()) {
+                    zigzag = reader.read(12);
+                } else if (!reader.read_bit()) {
+                    zigzag = reader.read(20);
+                } else if (!reader.read_bit()) {
+                    zigzag = reader.read(32);
+                } else {
+                    zigzag = reader.read(64);
+                }
+            }
+            int64_t dod = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            delta += dod;
+            previous += (uint64_t)delta;
+            out.push_back(bits_double(previous));
+        }
+        return;
+    }
+
+    int leading = 0;
+    int trailing = 0;
+    for (uint32_t i = 1; i < block.count; i++) {
+        if (reader.read_bit()) {
+            if (reader.read_bit()) {
+                leading = (int)reader.read(5);
+                int meaningful = (int)reader.read(6) + 1;
+                trailing = 64 - leading - meaningful;
+            }
+            previous ^= reader.read(64 - leading - trailing) << trailing;
+        }
+        out.push_back(bits_double(previous));
+    }
+}
+
+int WaveformStore::find_vector(const std::string &name) const {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+const std::vector<std::string> &WaveformStore::get_names() const {
+    return names;
+}
+
+size_t WaveformStore::get_sample_count() const {
+    return sample_count;
+}
+
+void WaveformStore::read_range(int vector, double t0, double t1, std::vector<double> &scale, std::vector<double> &values) {
+    scale.clear();
+    values.clear();
+    if (!is_configured() || vector < 0 || vector >= (int)names.size()) {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Blocks are in scale order, so the first overlapping one is found by bisection
+    std::vector<Block>::const_iterator it = std::lower_bound(blocks.begin(), blocks.end(), t0,
+        [](const Block &block, double t) { return block.scale_last < t; });
+
+    std::vector<double> block_scale;
+    std::vector<double> block_values;
+    size_t decoded = 0;
+    for (; it != blocks.end() && it->scale_first <= t1; ++it) {
+        block_scale.clear();
+        block_values.clear();
+        decode_block(*it, scale_index, block_scale);
+        decode_block(*it, vector, block_values);
+        decoded += it->count;
+
+        for (size_t i = 0; i < block_scale.size(); i++) {
+            if (block_scale[i] >= t0 && block_scale[i] <= t1) {
+                scale.push_back(block_scale[i]);
+                values.push_back(block_values[i]);
+            }
+        }
+    }
+
+    last_decode_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    last_decode_samples = decoded;
+}
+
+size_t WaveformStore::get_raw_bytes() const {
+    return sample_count * names.size() * sizeof(double);
+}
+
+size_t WaveformStore::get_compressed_bytes() const {
+    size_t bytes = blocks.capacity() * sizeof(Block) + compressed_words * sizeof(uint64_t);
+    if (!blocks.empty() && blocks.back().count < BLOCK_SIZE) {
+        for (const ColumnEncoder &encoder : encoders) {
+            bytes += encoder.bits.get_word_count() * sizeof(uint64_t);
+        }
+    }
+    return bytes;
+}
+
+double WaveformStore::get_decode_throughput() const {
+    if (last_decode_seconds <= 0.0) {
+        return 0.0;
+    }
+    return (double)last_decode_samples / last_decode_seconds;
+}
@@ -0,0 +1,114 @@
+#ifndef WAVEFORM_STORE_H
+#define WAVEFORM_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sim_arena.h"
+
+// Append-only bit stream over a caller-provided word buffer
+class BitWriter {
+private:
+    uint64_t* words;
+    size_t bit_count;
+
+public:
+    BitWriter();
+
+    void start(uint64_t* p_words);
+    void write(uint64_t value, int bits);
+    size_t get_bit_count() const;
+    size_t get_word_count() const;
+    const uint64_t* get_words() const;
+};
+
+class BitReader {
+private:
+    const uint64_t* words;
+    size_t position;
+
+public:
+    BitReader(const uint64_t* p_words);
+
+    uint64_t read(int bits);
+    bool read_bit();
+};
+
+// Compressed in-memory store for streamed simulation vectors, using the
+// Gorilla scheme: the scale (time) column is stored as delta-of-delta of its
+// IEEE-754 bit patterns, every other column as XOR against the previous
+// value. Both are lossless. Samples are grouped in blocks that decode
+// independently, so range queries only touch the blocks they overlap.
+class WaveformStore {
+public:
+    static const uint32_t BLOCK_SIZE = 512;
+
+    // Worst case per sample: 5 + 64 bits (scale) or 2 + 5 + 6 + 64 (value)
+    static const uint32_t MAX_BLOCK_WORDS = (BLOCK_SIZE * 80 + 63) / 64 + 1;
+
+private:
+    // Encoder of the open block of one column
+    struct ColumnEncoder {
+        uint64_t* scratch;
+        BitWriter bits;
+        uint64_t previous;
+        int64_t previous_delta;
+        int leading;
+        int trailing;
+    };
+
+    // Words of each column; the open block points at the encoders' scratch
+    // buffers until it is full, then its words are copied into the arena
+    struct Block {
+        size_t first_sample;
+        uint32_t count;
+        double scale_first;
+        double scale_last;
+        const uint64_t** columns;
+    };
+
+    std::vector<std::string> names;
+    int scale_index;
+    std::vector<Block> blocks;
+    size_t sample_count;
+    size_t compressed_words;
+
+    // Block storage, rewound on every reset()
+    SimArena arena;
+    std::vector<ColumnEncoder> encoders;
+    const uint64_t** scratch_columns;
+
+    double last_decode_seconds;
+    size_t last_decode_samples;
+
+    void encode_scale(ColumnEncoder &column, uint64_t bits, bool first);
+    void encode_value(ColumnEncoder &column, uint64_t bits, bool first);
+    void close_block(Block &block);
+    void decode_block(const Block &block, int column, std::vector<double> &out) const;
+
+public:
+    WaveformStore();
+
+    // Starts a new run with the given columns; 'scale' is the time column
+    void reset(const std::vector<std::string> &vector_names, int scale);
+    void clear();
+    bool is_configured() const;
+
+    void append_row(const double* values);
+
+    int find_vector(const std::string &name) const;
+    const std::vector<std::string> &get_names() const;
+    size_t get_sample_count() const;
+
+    // Samples with scale in [t0, t1]; decodes whole blocks, then trims
+    void read_range(int vector, double t0, double t1, std::vector<double> &scale, std::vector<double> &values);
+
+    size_t get_raw_bytes() const;
+    size_t get_compressed_bytes() const;
+    const SimArena::Stats &get_arena_stats() const { return arena.get_stats(); }
+    double get_decode_throughput() const;  // Samples per second of the last read_range
+};
+
+#endif // WAVEFORM_STORE_H
@@ -0,0 +1,40 @@
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal checks for the unit tests of the Godot-free modules. A failed
+// check is reported and counted; each test program returns non-zero if
+// any check failed.
+static int test_failures = 0;
+
+#define CHECK(condition)                                                     \
+    do {                                                                     \
+        if (!(condition)) {                                                  \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test_failures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                              \
+    do {                                                                     \
+        double check_actual = (actual);                                      \
+        double check_expected = (expected);                                  \
+        if (!(std::fabs(check_actual - check_expected) <= (tolerance))) {    \
+            fprintf(stderr, "%s:%d: %s = %.17g, expected %.17g\n", __FILE__, __LINE__, #actual, \
+                check_actual, check_expected);                               \
+            test_failures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+static int test_result(const char *name) {
+    if (test_failures > 0) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
+
+#endif // TEST_COMMON_H
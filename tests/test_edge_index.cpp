@@ -0,0 +1,111 @@
+#include "edge_index.h"
+#include "test_common.h"
+
+#include <vector>
+
+static void test_interpolated_edges() {
+    EdgeIndex index;
+    index.configure(2.0, 1.0);  // Order does not matter
+    CHECK(index.get_low() == 1.0 && index.get_high() == 2.0);
+
+    // 0 V until t=1, ramp to 3 V at t=2, hold, ramp down to 0 V at t=5
+    const double time[] = { 0.0, 1.0, 2.0, 4.0, 5.0, 6.0 };
+    const double value[] = { 0.0, 0.0, 3.0, 3.0, 0.0, 0.0 };
+    for (int i = 0; i < 6; i++) {
+        index.append(time[i], value[i]);
+    }
+
+    // Rising through 2 V at t = 1 + 2/3, falling through 1 V at t = 4 + 2/3
+    std::vector<double> times;
+    std::vector<uint8_t> rising;
+    index.get_edges(0.0, 10.0, times, rising);
+    CHECK(index.get_edge_count() == 2);
+    CHECK(times.size() == 2 && rising.size() == 2);
+    if (times.size() == 2) {
+        CHECK_NEAR(times[0], 1.0 + 2.0 / 3.0, 1e-15);
+        CHECK_NEAR(times[1], 4.0 + 2.0 / 3.0, 1e-15);
+        CHECK(rising[0] == 1 && rising[1] == 0);
+    }
+    CHECK(index.get_current_state() == EdgeIndex::STATE_LOW);
+}
+
+static void test_hysteresis() {
+    EdgeIndex index;
+    index.configure(1.0, 2.0);
+
+    // Starts inside the band: undefined until it leaves it, and that is no edge
+    index.append(0.0, 1.5);
+    CHECK(index.get_current_state() == EdgeIndex::STATE_UNKNOWN);
+    index.append(1.0, 2.5);
+    CHECK(index.get_current_state() == EdgeIndex::STATE_HIGH);
+    CHECK(index.get_edge_count() == 0);
+
+    // Ringing inside the band does not toggle
+    index.append(2.0, 1.2);
+    index.append(3.0, 1.9);
+    index.append(4.0, 1.1);
+    CHECK(index.get_edge_count() == 0);
+
+    // Reaching the threshold exactly counts
+    index.append(5.0, 1.0);
+    CHECK(index.get_edge_count() == 1);
+
+    std::vector<double> times;
+    std::vector<uint8_t> rising;
+    index.get_edges(0.0, 10.0, times, rising);
+    CHECK(times.size() == 1 && times[0] == 5.0 && rising[0] == 0);
+
+    CHECK(index.state_at(0.5) == EdgeIndex::STATE_UNKNOWN);
+    CHECK(index.state_at(1.0) == EdgeIndex::STATE_HIGH);
+    CHECK(index.state_at(4.99) == EdgeIndex::STATE_HIGH);
+    CHECK(index.state_at(5.0) == EdgeIndex::STATE_LOW);
+
+    index.reset();
+    CHECK(index.get_edge_count() == 0);
+    CHECK(index.get_current_state() == EdgeIndex::STATE_UNKNOWN);
+    CHECK(index.get_low() == 1.0 && index.get_high() == 2.0);
+}
+
+static void test_queries() {
+    // Square wave with a period of 1: rising at k + 0.25, falling at k + 0.75
+    EdgeIndex index;
+    index.configure(0.5, 0.5);
+    const int periods = 1000;
+    for (int k = 0; k < periods; k++) {
+        index.append(k + 0.0, 0.0);
+        index.append(k + 0.2, 0.0);
+        index.append(k + 0.3, 1.0);
+        index.append(k + 0.7, 1.0);
+        index.append(k + 0.8, 0.0);
+    }
+    CHECK(index.get_edge_count() == 2 * periods);
+
+    // Bounds are inclusive on both ends
+    CHECK(index.count_edges(0.0, (double)periods) == 2 * periods);
+    CHECK(index.count_edges(10.25, 10.75) == 2);
+    CHECK(index.count_edges(10.26, 10.74) == 0);
+    CHECK(index.count_edges(10.5, 20.5) == 20);
+    CHECK(index.count_edges(5.0, 4.0) == 0);
+
+    std::vector<double> times;
+    std::vector<uint8_t> rising;
+    index.get_edges(500.0, 502.0, times, rising);
+    CHECK(times.size() == 4);
+    if (times.size() == 4) {
+        CHECK_NEAR(times[0], 500.25, 1e-9);
+        CHECK_NEAR(times[3], 501.75, 1e-9);
+        CHECK(rising[0] == 1 && rising[1] == 0 && rising[2] == 1 && rising[3] == 0);
+    }
+
+    CHECK(index.state_at(0.1) == EdgeIndex::STATE_LOW);
+    CHECK(index.state_at(123.5) == EdgeIndex::STATE_HIGH);
+    CHECK(index.state_at(123.9) == EdgeIndex::STATE_LOW);
+    CHECK(index.state_at(-1.0) == EdgeIndex::STATE_UNKNOWN);
+}
+
+int main() {
+    test_interpolated_edges();
+    test_hysteresis();
+    test_queries();
+    return test_result("edge_index");
+}
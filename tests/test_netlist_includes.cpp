@@ -0,0 +1,28 @@
+#include "netlist_includes.h"
+#include "test_common.h"
+
+#include <string>
+
+static bool resolves_to(const char *line, const char *expected) {
+    std::string resolved;
+    return resolve_include_line(line, "/base/dir", resolved) && resolved == expected;
+}
+
+static bool left_alone(const char *line) {
+    std::string resolved = "untouched";
+    return !resolve_include_line(line, "/base/dir", resolved) && resolved == "untouched";
+}
+
+int main() {
+    CHECK(resolves_to(".include models/m.lib", ".include \"/base/dir/models/m.lib\""));
+    CHECK(resolves_to(".include \"models/m.lib\"", ".include \"/base/dir/models/m.lib\""));
+    CHECK(resolves_to("  .INC ../shared/diode.mod", ".INC \"/base/dir/../shared/diode.mod\""));
+    CHECK(resolves_to(".lib lib/x.lib tt", ".lib \"/base/dir/lib/x.lib\" tt"));
+
+    CHECK(left_alone(".include /abs/m.lib"));
+    CHECK(left_alone(".LIB sect"));
+    CHECK(left_alone(".endl"));
+    CHECK(left_alone("R1 in out 1k"));
+    CHECK(left_alone("* .include commented.lib"));
+    return test_result("netlist_includes");
+}
@@ -0,0 +1,59 @@
+#include "ngspice_library.h"
+#include "test_common.h"
+
+#include <cstring>
+
+// Stand-in for ngGet_Vec_Info, which fills one static struct on every call
+static double fake_time[3] = { 0.0, 1e-6, 2e-6 };
+static double fake_out[2] = { 3.3, 1.1 };
+
+static pvector_info fake_get_vec_info(char *name) {
+    static vector_info info;
+    if (strcmp(name, "time") == 0) {
+        info.v_realdata = fake_time;
+        info.v_length = 3;
+    } else if (strcmp(name, "v(out)") == 0) {
+        info.v_realdata = fake_out;
+        info.v_length = 2;
+    } else if (strcmp(name, "v(cplx)") == 0) {
+        info.v_realdata = nullptr;
+        info.v_length = 4;
+    } else {
+        return nullptr;
+    }
+    return &info;
+}
+
+static void test_lookups_do_not_alias() {
+    NgspiceLibrary ngspice;
+    ngspice.get_vec_info = fake_get_vec_info;
+
+    const double *time = nullptr;
+    const double *values = nullptr;
+    size_t time_count = 0;
+    size_t value_count = 0;
+    CHECK(ngspice.find_real_vector("time", time, time_count));
+    CHECK(ngspice.find_real_vector("v(out)", values, value_count));
+
+    // The second lookup overwrote the struct, not the first result
+    CHECK(time == fake_time && time_count == 3);
+    CHECK(values == fake_out && value_count == 2);
+}
+
+static void test_missing_vectors() {
+    NgspiceLibrary ngspice;
+    const double *data = fake_out;
+    size_t length = 2;
+    CHECK(!ngspice.find_real_vector("time", data, length));  // Library not loaded
+
+    ngspice.get_vec_info = fake_get_vec_info;
+    CHECK(!ngspice.find_real_vector("v(none)", data, length));
+    CHECK(!ngspice.find_real_vector("v(cplx)", data, length));  // No real data
+    CHECK(data == fake_out && length == 2);
+}
+
+int main() {
+    test_lookups_do_not_alias();
+    test_missing_vectors();
+    return test_result("ngspice_library");
+}
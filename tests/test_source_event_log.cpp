@@ -0,0 +1,130 @@
+#include "source_event_log.h"
+#include "test_common.h"
+
+#include <cstring>
+#include <vector>
+
+// Records a run with two sources; v1 changes twice, v2 once
+static void record_run(SourceEventLog &log) {
+    log.begin_recording();
+    uint32_t v1 = log.add_source("v1");
+    uint32_t v2 = log.add_source("v_clk");
+    CHECK(log.add_source("v1") == v1);
+
+    log.record(v1, 0.0, 1.0);    // 0: first value
+    log.record(v2, 0.0, 0.0);    // 1: first value
+    log.record(v1, 1e-6, 1.0);   // 2: unchanged
+    log.record(v1, 2e-6, 2.5);   // 3: change
+    log.record(v2, 2e-6, 0.0);   // 4: unchanged
+    log.record(v1, 1.5e-6, 2.5); // 5: step back, unchanged
+    log.record(v2, 3e-6, 3.3);   // 6: change
+    log.record(v1, 4e-6, -1.0);  // 7: change
+}
+
+static void test_recording() {
+    SourceEventLog log;
+    record_run(log);
+
+    CHECK(log.get_sources().size() == 2);
+    CHECK(log.find_source("v_clk") == 1);
+    CHECK(log.find_source("v2") == -1);
+
+    const std::vector<SourceEventLog::Event> &events = log.get_events();
+    CHECK(log.get_event_count() == 5);
+    if (events.size() == 5) {
+        CHECK(events[0].sequence == 0 && events[0].source == 0 && events[0].value == 1.0);
+        CHECK(events[1].sequence == 1 && events[1].source == 1 && events[1].value == 0.0);
+        CHECK(events[2].sequence == 3 && events[2].time == 2e-6 && events[2].value == 2.5);
+        CHECK(events[3].sequence == 6 && events[3].source == 1 && events[3].value == 3.3);
+        CHECK(events[4].sequence == 7 && events[4].value == -1.0);
+    }
+}
+
+static void test_round_trip() {
+    SourceEventLog log;
+    record_run(log);
+
+    std::vector<uint8_t> bytes;
+    log.serialize(bytes);
+    CHECK(bytes.size() == 8 + 4 + (2 + 2) + (2 + 5) + 8 + 5 * 28);
+    CHECK(memcmp(bytes.data(), "CSRL", 4) == 0);
+
+    SourceEventLog loaded;
+    CHECK(loaded.deserialize(bytes.data(), bytes.size()));
+    CHECK(loaded.get_sources() == log.get_sources());
+    CHECK(loaded.get_event_count() == log.get_event_count());
+    for (size_t i = 0; i < loaded.get_event_count() && i < log.get_event_count(); i++) {
+        const SourceEventLog::Event &a = loaded.get_events()[i];
+        const SourceEventLog::Event &b = log.get_events()[i];
+        CHECK(a.time == b.time && a.sequence == b.sequence && a.source == b.source && a.value == b.value);
+    }
+
+    std::vector<uint8_t> again;
+    loaded.serialize(again);
+    CHECK(again == bytes);
+}
+
+static void test_replay() {
+    SourceEventLog log;
+    record_run(log);
+    log.begin_replay();
+
+    // The same callback sequence sees each change at the same index
+    const uint32_t sources[8] = { 0, 1, 0, 0, 1, 0, 1, 0 };
+    const double expected[8] = { 1.0, 0.0, 1.0, 2.5, 0.0, 2.5, 3.3, -1.0 };
+    for (int i = 0; i < 8; i++) {
+        double value = 0.0;
+        CHECK(log.replay(sources[i], value));
+        CHECK(value == expected[i]);
+    }
+
+    // A source the log never set is left to the caller
+    SourceEventLog empty;
+    empty.add_source("v1");
+    empty.begin_replay();
+    double value = 7.0;
+    CHECK(!empty.replay(0, value));
+    CHECK(value == 7.0);
+}
+
+static void test_rejects_bad_data() {
+    SourceEventLog log;
+    record_run(log);
+    std::vector<uint8_t> bytes;
+    log.serialize(bytes);
+
+    SourceEventLog loaded;
+    for (size_t size = 0; size < bytes.size(); size++) {
+        if (loaded.deserialize(bytes.data(), size)) {
+            fprintf(stderr, "truncated log of %zu bytes accepted\n", size);
+            test_failures++;
+            break;
+        }
+        if (loaded.get_event_count() != 0 || !loaded.get_sources().empty()) {
+            fprintf(stderr, "truncated log of %zu bytes left data behind\n", size);
+            test_failures++;
+            break;
+        }
+    }
+
+    std::vector<uint8_t> bad = bytes;
+    bad[0] = 'X';
+    CHECK(!loaded.deserialize(bad.data(), bad.size()));
+
+    bad = bytes;
+    bad[4] = 2;  // Unknown version
+    CHECK(!loaded.deserialize(bad.data(), bad.size()));
+
+    // Event that names a source past the table
+    bad = bytes;
+    bad[bad.size() - 12] = 9;
+    CHECK(!loaded.deserialize(bad.data(), bad.size()));
+}
+
+int main() {
+    test_recording();
+    test_round_trip();
+    test_replay();
+    test_rejects_bad_data();
+    return test_result("source_event_log");
+}
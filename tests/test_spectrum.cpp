@@ -0,0 +1,122 @@
+#include "spectrum.h"
+#include "test_common.h"
+
+#include <algorithm>
+#include <complex>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+
+static void test_power_of_two() {
+    CHECK(SpectrumAnalyzer::is_power_of_two(1));
+    CHECK(SpectrumAnalyzer::is_power_of_two(1024));
+    CHECK(!SpectrumAnalyzer::is_power_of_two(0));
+    CHECK(!SpectrumAnalyzer::is_power_of_two(768));
+    CHECK(SpectrumAnalyzer::next_power_of_two(1000) == 1024);
+    CHECK(SpectrumAnalyzer::next_power_of_two(1024) == 1024);
+}
+
+static void test_matches_dft() {
+    const size_t size = 64;
+    std::vector<double> input(size);
+    for (size_t i = 0; i < size; i++) {
+        input[i] = std::sin(0.37 * (double)i) + 0.25 * std::cos(1.9 * (double)(i * i)) - 0.1;
+    }
+
+    std::shared_ptr<const FftPlan> plan = FftPlan::acquire(size);
+    CHECK(plan && plan->get_size() == size);
+    CHECK(FftPlan::acquire(size) == plan);  // Cached
+    if (!plan) {
+        return;
+    }
+
+    std::vector<std::complex<double>> output(size / 2 + 1);
+    std::vector<std::complex<double>> scratch;
+    plan->forward(input.data(), output.data(), scratch);
+
+    for (size_t k = 0; k <= size / 2; k++) {
+        std::complex<double> expected = 0.0;
+        for (size_t n = 0; n < size; n++) {
+            expected += input[n] * std::polar(1.0, -2.0 * PI * (double)(k * n) / (double)size);
+        }
+        CHECK_NEAR(output[k].real(), expected.real(), 1e-11);
+        CHECK_NEAR(output[k].imag(), expected.imag(), 1e-11);
+    }
+}
+
+static void test_known_sine() {
+    // 2.5 sin at bin 37 plus 0.75 DC: the amplitude spectrum reads them back
+    const size_t size = 1024;
+    const size_t bin = 37;
+    std::vector<double> samples(size);
+    for (size_t i = 0; i < size; i++) {
+        samples[i] = 0.75 + 2.5 * std::sin(2.0 * PI * (double)(bin * i) / (double)size);
+    }
+
+    std::vector<double> magnitude(size / 2 + 1);
+    std::vector<double> phase(size / 2 + 1);
+    SpectrumAnalyzer::analyze(samples.data(), size, SpectrumAnalyzer::WINDOW_RECTANGULAR, magnitude.data(),
+        phase.data());
+
+    CHECK_NEAR(magnitude[0], 0.75, 1e-12);
+    CHECK_NEAR(magnitude[bin], 2.5, 1e-12);
+    CHECK_NEAR(phase[bin], -PI / 2.0, 1e-9);  // sin = cos shifted by -90 degrees
+    double leakage = 0.0;
+    for (size_t k = 1; k < magnitude.size(); k++) {
+        if (k != bin) {
+            leakage = std::max(leakage, magnitude[k]);
+        }
+    }
+    CHECK(leakage < 1e-12);
+
+    // The flat-top window keeps the amplitude of a bin-centred tone
+    SpectrumAnalyzer::analyze(samples.data(), size, SpectrumAnalyzer::WINDOW_FLAT_TOP, magnitude.data(), nullptr);
+    CHECK_NEAR(magnitude[bin], 2.5, 1e-3);
+}
+
+static void test_resample() {
+    const double time[] = { 0.0, 0.1, 0.4, 1.0 };
+    const double values[] = { 0.0, 1.0, 4.0, 10.0 };
+    double out[10];
+    CHECK(SpectrumAnalyzer::resample(time, values, 4, 0.0, 1.0, 10, out));
+    for (int i = 0; i < 10; i++) {
+        CHECK_NEAR(out[i], 10.0 * 0.1 * i, 1e-12);
+    }
+    CHECK(!SpectrumAnalyzer::resample(time, values, 1, 0.0, 1.0, 10, out));
+    CHECK(!SpectrumAnalyzer::resample(time, values, 4, 1.0, 1.0, 10, out));
+}
+
+static void test_spectrogram() {
+    // Tone at bin 4 of a 32-sample frame, then at bin 8
+    const size_t frame = 32;
+    const size_t count = 256;
+    std::vector<double> samples(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t bin = i < count / 2 ? 4 : 8;
+        samples[i] = std::cos(2.0 * PI * (double)(bin * i) / (double)frame);
+    }
+
+    size_t frames = SpectrumAnalyzer::get_frame_count(count, frame, frame);
+    CHECK(frames == 8);
+    CHECK(SpectrumAnalyzer::get_frame_count(count, frame, 16) == 15);
+    CHECK(SpectrumAnalyzer::get_frame_count(16, frame, 16) == 0);
+
+    size_t bins = frame / 2 + 1;
+    std::vector<double> magnitude(frames * bins);
+    SpectrumAnalyzer::spectrogram(samples.data(), count, frame, frame, SpectrumAnalyzer::WINDOW_RECTANGULAR, 3,
+        magnitude.data());
+    for (size_t f = 0; f < frames; f++) {
+        size_t bin = f < frames / 2 ? 4 : 8;
+        CHECK_NEAR(magnitude[f * bins + bin], 1.0, 1e-12);
+        CHECK_NEAR(magnitude[f * bins + 12 - bin], 0.0, 1e-12);
+    }
+}
+
+int main() {
+    test_power_of_two();
+    test_matches_dft();
+    test_known_sine();
+    test_resample();
+    test_spectrogram();
+    return test_result("spectrum");
+}
@@ -0,0 +1,137 @@
+#include "stream_snapshot.h"
+#include "test_common.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Row i holds time i * 1e-6 and value 2 * i, so any row can be checked alone
+static void append_rows(SnapshotPublisher &publisher, size_t first, size_t count) {
+    for (size_t i = first; i < first + count; i++) {
+        double row[2] = { (double)i * 1e-6, 2.0 * (double)i };
+        publisher.append(row);
+        publisher.publish();
+    }
+}
+
+static void test_publish_and_read() {
+    SnapshotPublisher publisher;
+    CHECK(!publisher.acquire());
+
+    publisher.reset({ "time", "v(out)" }, { "time", "out" }, 0, 7);
+    std::shared_ptr<const StreamSnapshot> empty = publisher.acquire();
+    CHECK(empty && empty->get_row_count() == 0);
+
+    // More blocks than the initial directory holds, so it grows
+    const size_t count = StreamSnapshot::BLOCK_ROWS * 20 + 5;
+    append_rows(publisher, 0, count);
+    std::shared_ptr<const StreamSnapshot> snapshot = publisher.acquire();
+    CHECK(snapshot->get_row_count() == count);
+    CHECK(snapshot->get_column_count() == 2);
+    CHECK(snapshot->get_layout().generation == 7);
+    CHECK(snapshot->find_column("out") == 1);
+    CHECK(snapshot->find_column("v(out)") == -1);
+
+    bool values_ok = true;
+    for (size_t i = 0; i < count; i++) {
+        values_ok = values_ok && snapshot->get_value(1, i) == 2.0 * (double)i;
+    }
+    CHECK(values_ok);
+
+    // Across a block boundary, clipped to the row count
+    size_t begin = StreamSnapshot::BLOCK_ROWS - 3;
+    std::vector<double> column(10, -1.0);
+    snapshot->copy_column(1, begin, begin + 6, column.data());
+    for (size_t i = 0; i < 6; i++) {
+        CHECK(column[i] == 2.0 * (double)(begin + i));
+    }
+    CHECK(column[6] == -1.0);
+    column.assign(10, -1.0);
+    snapshot->copy_column(1, count - 2, count + 5, column.data());
+    CHECK(column[0] == 2.0 * (double)(count - 2));
+    CHECK(column[1] == 2.0 * (double)(count - 1));
+    CHECK(column[2] == -1.0);
+}
+
+static void test_old_snapshots_stay() {
+    SnapshotPublisher publisher;
+    publisher.reset({ "time", "v(out)" }, { "time", "out" }, 0, 1);
+    append_rows(publisher, 0, 100);
+    std::shared_ptr<const StreamSnapshot> early = publisher.acquire();
+
+    // Growth and a new run leave a held snapshot as it was
+    append_rows(publisher, 100, StreamSnapshot::BLOCK_ROWS * 40);
+    publisher.reset({ "time" }, { "time" }, 0, 2);
+    CHECK(early->get_row_count() == 100);
+    CHECK(early->get_value(1, 99) == 198.0);
+    CHECK(early->get_layout().generation == 1);
+
+    std::shared_ptr<const StreamSnapshot> fresh = publisher.acquire();
+    CHECK(fresh->get_row_count() == 0 && fresh->get_column_count() == 1);
+
+    publisher.clear();
+    CHECK(!publisher.acquire());
+}
+
+static void test_time_queries() {
+    SnapshotPublisher publisher;
+    publisher.reset({ "time", "v(out)" }, { "time", "out" }, 0, 1);
+    append_rows(publisher, 0, 5000);
+    std::shared_ptr<const StreamSnapshot> snapshot = publisher.acquire();
+
+    CHECK(snapshot->count_rows_until(-1.0) == 0);
+    CHECK(snapshot->count_rows_until(0.0) == 1);
+    CHECK(snapshot->count_rows_before(0.0) == 0);
+    CHECK(snapshot->count_rows_until(2999e-6) == 3000);
+    CHECK(snapshot->count_rows_before(2999e-6) == 2999);
+    CHECK(snapshot->count_rows_until(2999.5e-6) == 3000);
+    CHECK(snapshot->count_rows_until(1.0) == 5000);
+
+    std::shared_ptr<const StreamSnapshot> head = snapshot->truncated(1500);
+    CHECK(head->get_row_count() == 1500);
+    CHECK(head->count_rows_until(1.0) == 1500);
+    CHECK(snapshot->truncated(9999)->get_row_count() == 5000);
+}
+
+static void test_concurrent_reader() {
+    // A reader never sees a row that was not written, or a row count paired
+    // with the wrong run
+    SnapshotPublisher publisher;
+    publisher.reset({ "time", "v(out)" }, { "time", "out" }, 0, 0);
+
+    std::atomic<bool> done(false);
+    std::atomic<int> bad(0);
+    std::thread reader([&]() {
+        while (!done.load()) {
+            std::shared_ptr<const StreamSnapshot> snapshot = publisher.acquire();
+            size_t rows = snapshot->get_row_count();
+            if (rows > 0) {
+                double expected = 2.0 * (double)(rows - 1) + (double)snapshot->get_layout().generation;
+                if (snapshot->get_value(1, rows - 1) != expected) {
+                    bad++;
+                }
+            }
+        }
+    });
+
+    for (uint64_t generation = 0; generation < 20; generation++) {
+        publisher.reset({ "time", "v(out)" }, { "time", "out" }, 0, generation);
+        for (size_t i = 0; i < StreamSnapshot::BLOCK_ROWS * 20; i++) {
+            double row[2] = { (double)i * 1e-6, 2.0 * (double)i + (double)generation };
+            publisher.append(row);
+            publisher.publish();
+        }
+    }
+    done = true;
+    reader.join();
+    CHECK(bad.load() == 0);
+}
+
+int main() {
+    test_publish_and_read();
+    test_old_snapshots_stay();
+    test_time_queries();
+    test_concurrent_reader();
+    return test_result("stream_snapshot");
+}
@@ -0,0 +1,192 @@
+#include "waveform_compare.h"
+#include "test_common.h"
+
+#include <limits>
+#include <vector>
+
+// Piecewise-linear waveform sampled on two different time bases, so
+// interpolation onto the merged base reproduces it exactly
+struct Waveform {
+    std::vector<double> time;
+    std::vector<double> values;
+};
+
+static double ramp(double t) {
+    return t < 1.0 ? 2.0 * t : 2.0;
+}
+
+static Waveform sample(double step, double end) {
+    Waveform w;
+    for (double t = 0.0; t < end; t += step) {
+        w.time.push_back(t);
+        w.values.push_back(ramp(t));
+    }
+    w.time.push_back(end);
+    w.values.push_back(ramp(end));
+    // The corner must be a sample for the waveform to be exact
+    for (size_t i = 1; i < w.time.size(); i++) {
+        if (w.time[i - 1] < 1.0 && w.time[i] > 1.0) {
+            w.time.insert(w.time.begin() + i, 1.0);
+            w.values.insert(w.values.begin() + i, 2.0);
+            break;
+        }
+    }
+    return w;
+}
+
+static WaveformCompare::Pair make_pair(const Waveform &reference, const Waveform &run) {
+    WaveformCompare::Pair pair;
+    pair.reference_time = reference.time.data();
+    pair.reference = reference.values.data();
+    pair.reference_count = reference.time.size();
+    pair.time = run.time.data();
+    pair.values = run.values.data();
+    pair.count = run.time.size();
+    return pair;
+}
+
+static void test_interpolate() {
+    const double t[] = { 0.0, 1.0, 3.0 };
+    const double v[] = { 0.0, 10.0, 30.0 };
+    const double x[] = { -1.0, 0.5, 1.0, 2.0, 5.0 };
+    double out[5];
+    WaveformCompare::interpolate(t, v, 3, x, 5, out);
+    CHECK(out[0] == 0.0);   // Clamped
+    CHECK(out[1] == 5.0);
+    CHECK(out[2] == 10.0);
+    CHECK(out[3] == 20.0);
+    CHECK(out[4] == 30.0);  // Clamped
+}
+
+static void test_different_time_bases() {
+    Waveform reference = sample(0.01, 2.0);
+    Waveform run = sample(0.037, 2.0);
+
+    WaveformCompare::Settings settings;
+    settings.absolute = 1e-9;
+    WaveformCompare::Scratch scratch;
+    WaveformCompare::Result result = WaveformCompare::compare(make_pair(reference, run), settings, scratch);
+
+    CHECK(result.valid);
+    CHECK(result.passed);
+    CHECK(result.violations == 0);
+    CHECK(result.first_fail_time == -1.0);
+    CHECK_NEAR(result.coverage, 1.0, 1e-12);
+    CHECK(result.t0 == 0.0 && result.t1 == 2.0);
+    CHECK(result.max_error < 1e-12);
+    // Every timepoint of both runs is on the merged base
+    CHECK(result.points >= reference.time.size() && result.points < reference.time.size() + run.time.size());
+}
+
+static void test_spike() {
+    Waveform reference = sample(0.01, 2.0);
+    Waveform run = sample(0.037, 2.0);
+
+    // A spike between two reference timepoints still lands on a sample
+    for (size_t i = 0; i < run.time.size(); i++) {
+        if (run.time[i] > 1.5) {
+            run.values[i] += 0.5;
+            break;
+        }
+    }
+
+    WaveformCompare::Settings settings;
+    settings.absolute = 0.1;
+    WaveformCompare::Scratch scratch;
+    WaveformCompare::Result result = WaveformCompare::compare(make_pair(reference, run), settings, scratch);
+
+    CHECK(result.valid);
+    CHECK(!result.passed);
+    CHECK(result.violations > 0);
+    CHECK_NEAR(result.max_error, 0.5, 1e-12);
+    CHECK(result.max_error_time > 1.5 && result.max_error_time < 1.54);
+    // The band is left on the way up to the spike
+    CHECK(result.first_fail_time > 1.47 && result.first_fail_time <= result.max_error_time);
+
+    // A relative tolerance of 30 % covers 0.5 on a 2 V level
+    settings.relative = 0.3;
+    result = WaveformCompare::compare(make_pair(reference, run), settings, scratch);
+    CHECK(result.passed);
+}
+
+static void test_incomplete_run() {
+    Waveform reference = sample(0.01, 2.0);
+    Waveform run = sample(0.01, 1.5);
+
+    WaveformCompare::Settings settings;
+    WaveformCompare::Scratch scratch;
+    WaveformCompare::Result result = WaveformCompare::compare(make_pair(reference, run), settings, scratch);
+    CHECK(result.valid);
+    CHECK(!result.passed);
+    CHECK(result.violations == 0);
+    CHECK_NEAR(result.coverage, 0.75, 1e-12);
+    CHECK(result.first_fail_time == 1.5);
+
+    // Only the requested window has to be covered
+    settings.t1 = 1.5;
+    result = WaveformCompare::compare(make_pair(reference, run), settings, scratch);
+    CHECK(result.passed);
+
+    // No overlap at all
+    Waveform late;
+    late.time = { 3.0, 4.0 };
+    late.values = { 2.0, 2.0 };
+    settings.t1 = -1.0;
+    result = WaveformCompare::compare(make_pair(reference, late), settings, scratch);
+    CHECK(!result.valid);
+    CHECK(!result.passed);
+}
+
+static void test_nonfinite() {
+    Waveform reference = sample(0.01, 2.0);
+    Waveform run = reference;
+    run.values[50] = std::numeric_limits<double>::quiet_NaN();
+
+    WaveformCompare::Settings settings;
+    settings.absolute = 1.0;
+    WaveformCompare::Scratch scratch;
+    WaveformCompare::Result result = WaveformCompare::compare(make_pair(reference, run), settings, scratch);
+    CHECK(result.valid);
+    CHECK(!result.passed);
+    CHECK(result.max_error == std::numeric_limits<double>::infinity());
+    CHECK(result.max_error_time == run.time[50]);
+}
+
+static void test_batch() {
+    Waveform reference = sample(0.01, 2.0);
+    std::vector<Waveform> runs;
+    for (int i = 0; i < 9; i++) {
+        runs.push_back(sample(0.011 + 0.003 * i, 2.0));
+        if (i % 3 == 0) {
+            runs.back().values[runs.back().values.size() / 2] += 1.0;
+        }
+    }
+    std::vector<WaveformCompare::Pair> pairs;
+    for (const Waveform &run : runs) {
+        pairs.push_back(make_pair(reference, run));
+    }
+
+    WaveformCompare::Settings settings;
+    std::vector<WaveformCompare::Result> results;
+    WaveformCompare::compare_batch(pairs, settings, results, 4);
+    CHECK(results.size() == runs.size());
+
+    // Same results as one at a time
+    WaveformCompare::Scratch scratch;
+    for (size_t i = 0; i < results.size(); i++) {
+        WaveformCompare::Result single = WaveformCompare::compare(pairs[i], settings, scratch);
+        CHECK(results[i].passed == (i % 3 != 0));
+        CHECK(results[i].passed == single.passed && results[i].max_error == single.max_error &&
+            results[i].rms_error == single.rms_error && results[i].points == single.points);
+    }
+}
+
+int main() {
+    test_interpolate();
+    test_different_time_bases();
+    test_spike();
+    test_incomplete_run();
+    test_nonfinite();
+    test_batch();
+    return test_result("waveform_compare");
+}
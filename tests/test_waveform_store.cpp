@@ -0,0 +1,155 @@
+#include "waveform_store.h"
+#include "test_common.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+static uint64_t bits_of(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Same bit pattern, so -0.0, NaN payloads and denormals count too
+static bool same_bits(const std::vector<double> &a, const std::vector<double> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (bits_of(a[i]) != bits_of(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Adaptive-looking time steps and values that exercise every encoding:
+// repeats, small and large XOR windows, sign flips and special values
+static void make_rows(size_t count, std::vector<double> &time, std::vector<double> &smooth,
+        std::vector<double> &rough) {
+    double t = 0.0;
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (size_t i = 0; i < count; i++) {
+        time.push_back(t);
+        t += (i % 97 == 0) ? 1e-9 : 1e-7 * (1.0 + 0.25 * std::sin((double)i));
+
+        smooth.push_back(i % 5 == 0 ? (smooth.empty() ? 0.0 : smooth.back()) : std::sin(t * 1e5));
+
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        double value;
+        memcpy(&value, &state, sizeof(value));
+        switch (i % 11) {
+            case 0:
+                value = -0.0;
+                break;
+            case 1:
+                value = std::numeric_limits<double>::denorm_min();
+                break;
+            case 2:
+                value = std::numeric_limits<double>::infinity();
+                break;
+            case 3:
+                value = -1.0;
+                break;
+            default:
+                break;
+        }
+        rough.push_back(value);
+    }
+}
+
+static void test_round_trip() {
+    const size_t count = WaveformStore::BLOCK_SIZE * 3 + 17;
+    std::vector<double> time, smooth, rough;
+    make_rows(count, time, smooth, rough);
+
+    WaveformStore store;
+    store.reset({ "time", "v(out)", "v(noise)" }, 0);
+    CHECK(store.is_configured());
+    for (size_t i = 0; i < count; i++) {
+        double row[3] = { time[i], smooth[i], rough[i] };
+        store.append_row(row);
+    }
+    CHECK(store.get_sample_count() == count);
+    CHECK(store.find_vector("v(noise)") == 2);
+    CHECK(store.find_vector("v(missing)") == -1);
+
+    // Full range, including the open block
+    std::vector<double> scale, values;
+    double end = time.back();
+    store.read_range(1, 0.0, end, scale, values);
+    CHECK(same_bits(scale, time));
+    CHECK(same_bits(values, smooth));
+
+    store.read_range(2, 0.0, end, scale, values);
+    CHECK(same_bits(scale, time));
+    CHECK(same_bits(values, rough));
+
+    store.read_range(0, 0.0, end, scale, values);
+    CHECK(same_bits(values, time));
+}
+
+static void test_range_query() {
+    const size_t count = WaveformStore::BLOCK_SIZE * 4;
+    std::vector<double> time, smooth, rough;
+    make_rows(count, time, smooth, rough);
+
+    WaveformStore store;
+    store.reset({ "v(out)", "time" }, 1);
+    for (size_t i = 0; i < count; i++) {
+        double row[2] = { smooth[i], time[i] };
+        store.append_row(row);
+    }
+
+    // A range that starts and ends inside different blocks
+    size_t first = WaveformStore::BLOCK_SIZE / 2;
+    size_t last = WaveformStore::BLOCK_SIZE * 2 + 3;
+    std::vector<double> scale, values;
+    store.read_range(0, time[first], time[last], scale, values);
+    CHECK(same_bits(scale, std::vector<double>(time.begin() + first, time.begin() + last + 1)));
+    CHECK(same_bits(values, std::vector<double>(smooth.begin() + first, smooth.begin() + last + 1)));
+
+    store.read_range(0, time.back() + 1.0, time.back() + 2.0, scale, values);
+    CHECK(scale.empty() && values.empty());
+
+    store.read_range(5, 0.0, time.back(), scale, values);
+    CHECK(scale.empty() && values.empty());
+}
+
+static void test_compression() {
+    // A regular time step and a slowly changing value compress well
+    WaveformStore store;
+    store.reset({ "time", "v(out)" }, 0);
+    for (size_t i = 0; i < 10000; i++) {
+        double row[2] = { (double)i * 1e-6, i < 5000 ? 0.0 : 3.3 };
+        store.append_row(row);
+    }
+    CHECK(store.get_raw_bytes() == 10000 * 2 * sizeof(double));
+    CHECK(store.get_compressed_bytes() * 4 < store.get_raw_bytes());
+}
+
+static void test_reset() {
+    WaveformStore store;
+    CHECK(!store.is_configured());
+
+    store.reset({ "time", "a" }, 0);
+    double row[2] = { 0.0, 1.0 };
+    store.append_row(row);
+    store.reset({ "time", "b" }, 0);
+    CHECK(store.get_sample_count() == 0);
+    CHECK(store.find_vector("a") == -1);
+
+    std::vector<double> scale, values;
+    store.read_range(1, 0.0, 1.0, scale, values);
+    CHECK(values.empty());
+}
+
+int main() {
+    test_round_trip();
+    test_range_query();
+    test_compression();
+    test_reset();
+    return test_result("waveform_store");
+}
@@ -0,0 +1,359 @@
+// Headless batch runner.
+//
+// Runs every netlist in a directory through a pool of sim_worker processes
+// (the same backend as SimWorkerPool, without the Godot runtime) and writes
+// one packed result file per netlist plus a summary with timings.
+//
+// Usage: sim_batch [options] <netlist-dir> <output-dir>
+//   -c <command>      Analysis command, repeatable (e.g. -c "tran 1u 1m")
+//   -s <spec-file>    Analysis commands, one per line ('#' comments)
+//   -j <workers>      Worker processes (default: one per core)
+//   -t <seconds>      Per-job timeout (default 60, 0 = none)
+//   -w <sim_worker>   Worker executable (default: next to sim_batch)
+//   -l <library>      ngspice library passed to the workers
+//   -r <doubles>      Result ring size per worker (default 1048576)
+//
+// Output for <name>.<ext> (the full file name, so a.cir and a.sp do not
+// overwrite each other):
+//   <name>.<ext>.bin  "CSBR", uint32 version (2), uint32 analysis count,
+//                     then per analysis, in command order: uint32 vector
+//                     count, per vector uint32 name length, name, uint64
+//                     sample count, followed by that analysis' samples as
+//                     float64. Little endian.
+//   <name>.<ext>.log  ngspice console output and the error, if any
+//   summary.csv       file, status, wall time, vectors, samples, error
+//                     (vectors and samples summed over all analyses)
+
+#include "netlist_includes.h"
+#include "sim_process.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char RESULT_MAGIC[4] = { 'C', 'S', 'B', 'R' };
+static const uint32_t RESULT_VERSION = 2;
+
+static bool is_little_endian() {
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
+
+// Values are stored little endian regardless of host order
+template <typename T>
+static void put(std::vector<uint8_t> &out, T value) {
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    bool little = is_little_endian();
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(bytes[little ? i : sizeof(T) - 1 - i]);
+    }
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: sim_batch [-c command]... [-s spec-file] [-j workers] [-t seconds]\n"
+        "                 [-w sim_worker] [-l library] [-r ring-doubles] <netlist-dir> <output-dir>\n");
+}
+
+static bool read_lines(const fs::path &path, std::vector<std::string> &lines) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        lines.push_back(line);
+    }
+    return true;
+}
+
+static bool is_netlist(const fs::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return (char)tolower(c); });
+    return extension == ".spice" || extension == ".cir" || extension == ".sp" || extension == ".net"
+        || extension == ".ckt";
+}
+
+static bool write_file(const fs::path &path, const void *data, size_t size) {
+    FILE *file = fopen(path.string().c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = size == 0 || fwrite(data, 1, size, file) == size;
+    return (fclose(file) == 0) && ok;
+}
+
+static void put_analysis(std::vector<uint8_t> &out, const SimAnalysis &analysis) {
+    size_t row_count = analysis.get_row_count();
+    put<uint32_t>(out, (uint32_t)analysis.vector_names.size());
+    for (const std::string &name : analysis.vector_names) {
+        put<uint32_t>(out, (uint32_t)name.size());
+        out.insert(out.end(), name.begin(), name.end());
+        put<uint64_t>(out, (uint64_t)row_count);
+    }
+
+    // Rows are interleaved; the file stores one vector after the other
+    std::vector<double> column(row_count);
+    for (size_t i = 0; i < analysis.vector_names.size(); i++) {
+        analysis.copy_vector(i, column.data());
+        if (is_little_endian()) {
+            const uint8_t *bytes = (const uint8_t*)column.data();
+            out.insert(out.end(), bytes, bytes + row_count * sizeof(double));
+        } else {
+            for (double value : column) {
+                put<double>(out, value);
+            }
+        }
+    }
+}
+
+static bool write_result(const fs::path &path, const SimJob &job, uint64_t &vectors, uint64_t &samples) {
+    std::vector<uint8_t> out;
+    size_t reserve = 12;
+    for (const SimAnalysis &analysis : job.analyses) {
+        reserve += 4 + analysis.vector_names.size() * 64 + analysis.rows.size() * sizeof(double);
+    }
+    out.reserve(reserve);
+
+    out.insert(out.end(), RESULT_MAGIC, RESULT_MAGIC + 4);
+    put<uint32_t>(out, RESULT_VERSION);
+    put<uint32_t>(out, (uint32_t)job.analyses.size());
+    vectors = 0;
+    samples = 0;
+    for (const SimAnalysis &analysis : job.analyses) {
+        put_analysis(out, analysis);
+        vectors += analysis.vector_names.size();
+        samples += (uint64_t)analysis.get_row_count() * analysis.vector_names.size();
+    }
+
+    return write_file(path, out.data(), out.size());
+}
+
+static std::string csv_field(const std::string &text) {
+    std::string field = "\"";
+    for (char c : text) {
+        if (c == '"') {
+            field += "\"\"";
+        } else if (c == '\n' || c == '\r') {
+            field += ' ';
+        } else {
+            field += c;
+        }
+    }
+    return field + "\"";
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> commands;
+    int worker_count = 0;
+    double timeout = 60.0;
+    std::string executable;
+    std::string library;
+    uint64_t ring_doubles = 1 << 20;
+    std::vector<std::string> positional;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "-c" && has_value) {
+            commands.push_back(argv[++i]);
+        } else if (arg == "-s" && has_value) {
+            std::vector<std::string> lines;
+            if (!read_lines(argv[++i], lines)) {
+                fprintf(stderr, "sim_batch: cannot read spec %s\n", argv[i]);
+                return 2;
+            }
+            for (const std::string &line : lines) {
+                size_t first = line.find_first_not_of(" \t");
+                if (first != std::string::npos && line[first] != '#') {
+                    commands.push_back(line.substr(first));
+                }
+            }
+        } else if (arg == "-j" && has_value) {
+            worker_count = atoi(argv[++i]);
+        } else if (arg == "-t" && has_value) {
+            timeout = atof(argv[++i]);
+        } else if (arg == "-w" && has_value) {
+            executable = argv[++i];
+        } else if (arg == "-l" && has_value) {
+            library = argv[++i];
+        } else if (arg == "-r" && has_value) {
+            ring_doubles = strtoull(argv[++i], nullptr, 10);
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage();
+            return 2;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 2 || commands.empty()) {
+        usage();
+        return 2;
+    }
+    fs::path input_dir = positional[0];
+    fs::path output_dir = positional[1];
+
+    if (worker_count <= 0) {
+        worker_count = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    if (executable.empty()) {
+#ifdef _WIN32
+        const char *worker_name = "sim_worker.exe";
+#else
+        const char *worker_name = "sim_worker";
+#endif
+        executable = (fs::absolute(argv[0]).parent_path() / worker_name).string();
+    }
+
+    std::error_code ec;
+    std::vector<fs::path> netlists;
+    for (const fs::directory_entry &entry : fs::directory_iterator(input_dir, ec)) {
+        if (entry.is_regular_file() && is_netlist(entry.path())) {
+            netlists.push_back(entry.path());
+        }
+    }
+    if (ec) {
+        fprintf(stderr, "sim_batch: cannot list %s: %s\n", input_dir.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+    std::sort(netlists.begin(), netlists.end());
+    if (netlists.empty()) {
+        fprintf(stderr, "sim_batch: no netlists in %s\n", input_dir.string().c_str());
+        return 1;
+    }
+
+    fs::create_directories(output_dir, ec);
+    if (ec) {
+        fprintf(stderr, "sim_batch: cannot create %s: %s\n", output_dir.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    SimProcessPool pool;
+    std::string error;
+    worker_count = std::min(worker_count, (int)netlists.size());
+    if (!pool.start(executable, library, worker_count, ring_doubles, error)) {
+        fprintf(stderr, "sim_batch: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    // Job id -> netlist index; unreadable files fail without a job
+    std::map<int, size_t> job_files;
+    std::vector<std::string> summary(netlists.size());
+    int failed = 0;
+    for (size_t i = 0; i < netlists.size(); i++) {
+        std::vector<std::string> lines;
+        if (!read_lines(netlists[i], lines)) {
+            summary[i] = csv_field(netlists[i].filename().string()) + ",failed,0,0,0," + csv_field("cannot read file");
+            failed++;
+            continue;
+        }
+        // Relative includes resolve against the netlist, not the worker's cwd
+        std::string base_dir = fs::absolute(netlists[i]).parent_path().generic_string();
+        std::string resolved;
+        for (std::string &line : lines) {
+            if (resolve_include_line(line.c_str(), base_dir, resolved)) {
+                line = resolved;
+            }
+        }
+        job_files[pool.submit(lines, commands, timeout)] = i;
+    }
+
+    // Workers that die and cannot be restarted would stall the queue
+    const int max_restarts_without_progress = worker_count * 4;
+    int restarts_without_progress = 0;
+    size_t remaining = job_files.size();
+    std::vector<int> finished;
+    std::vector<int> crashed;
+    while (remaining > 0) {
+        finished.clear();
+        crashed.clear();
+        pool.poll(finished, crashed);
+
+        restarts_without_progress = finished.empty() ? restarts_without_progress + (int)crashed.size() : 0;
+        if (restarts_without_progress > max_restarts_without_progress) {
+            fprintf(stderr, "sim_batch: workers keep failing to start, giving up\n");
+            pool.stop();
+            return 1;
+        }
+
+        for (int job_id : finished) {
+            SimJob *job = pool.get_job(job_id);
+            auto it = job_files.find(job_id);
+            if (!job || it == job_files.end()) {
+                continue;
+            }
+            const fs::path &netlist = netlists[it->second];
+            std::string name = netlist.filename().string();
+            bool success = job->state == SimJob::DONE;
+
+            uint64_t vectors = 0;
+            uint64_t samples = 0;
+            if (success && !write_result(output_dir / (name + ".bin"), *job, vectors, samples)) {
+                success = false;
+                job->error = "cannot write result";
+            }
+
+            std::string log;
+            for (const std::string &line : job->output) {
+                log += line;
+                log += '\n';
+            }
+            if (!job->error.empty()) {
+                log += "error: " + job->error + "\n";
+            }
+            write_file(output_dir / (name + ".log"), log.data(), log.size());
+
+            char timing[32];
+            snprintf(timing, sizeof(timing), "%.6f", job->wall_time);
+            summary[it->second] = csv_field(name) + (success ? ",ok," : ",failed,") + timing
+                + "," + std::to_string(vectors) + "," + std::to_string(samples) + ","
+                + csv_field(job->error);
+            if (!success) {
+                failed++;
+            }
+
+            printf("%s %s %.3fs\n", success ? "ok    " : "FAILED", name.c_str(), job->wall_time);
+            fflush(stdout);
+            pool.release_job(job_id);
+            remaining--;
+        }
+
+        if (finished.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    pool.stop();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    std::string csv = "file,status,wall_time,vectors,samples,error\n";
+    for (const std::string &row : summary) {
+        csv += row + "\n";
+    }
+    if (!write_file(output_dir / "summary.csv", csv.data(), csv.size())) {
+        fprintf(stderr, "sim_batch: cannot write summary.csv\n");
+        return 1;
+    }
+
+    printf("%zu netlists, %d failed, %d workers, %.3fs (%.1f netlists/s)\n",
+        netlists.size(), failed, worker_count, elapsed, elapsed > 0.0 ? netlists.size() / elapsed : 0.0);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,226 @@
+// Out-of-process simulation worker.
+//
+// Wraps libngspice in its own process so that a crash or controlled exit
+// of ngspice cannot take down the host, and so several simulations can run
+// at once. Requests arrive on stdin and replies go to stdout using the line
+// protocol described in src/sim_process.h; vector data is streamed into the
+// shared-memory SimRing named on the command line.
+//
+// Usage: sim_worker <shm-name> [ngspice-library]
+
+#include "ngspice_library.h"
+#include "sim_ring.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static NgspiceLibrary ngspice;
+static SimSharedMemory shm;
+static SimRing ring;
+
+static std::mutex output_mutex;
+static std::vector<double> row;
+static bool drop_rows = false;
+
+#ifndef _WIN32
+static pid_t host_pid = 0;
+#endif
+
+static void send_line(const std::string &line) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+    fwrite(line.data(), 1, line.size(), stdout);
+    fputc('\n', stdout);
+    fflush(stdout);
+}
+
+// Waiting on the ring must not outlive the host
+static bool host_alive() {
+#ifdef _WIN32
+    return true;
+#else
+    return getppid() == host_pid;
+#endif
+}
+
+static void wait_for_ring() {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    if (!host_alive()) {
+        std::_Exit(1);
+    }
+}
+
+// Callback functions for ngspice
+static int ng_send_char(char *output, int id, void *user_data) {
+    std::string line = "out ";
+    line += output;
+    // Output lines never contain the protocol's line separator
+    for (char &c : line) {
+        if (c == '\n' || c == '\r') {
+            c = ' ';
+        }
+    }
+    send_line(line);
+    return 0;
+}
+
+static int ng_send_stat(char *status, int id, void *user_data) {
+    return 0;
+}
+
+static int ng_controlled_exit(int status, bool immediate, bool exit_on_quit, int id, void *user_data) {
+    // The host restarts the worker, so exiting here is safe
+    send_line("exit " + std::to_string(status));
+    std::_Exit(status);
+    return 0;
+}
+
+static int ng_send_data(pvecvaluesall data, int count, int id, void *user_data) {
+    if (drop_rows || (size_t)data->veccount != row.size()) {
+        return 0;
+    }
+
+    for (int i = 0; i < data->veccount; i++) {
+        row[i] = data->vecsa[i]->creal;
+    }
+
+    // Back-pressure: block the simulation until the host has read enough
+    while (!ring.write(row.data(), row.size())) {
+        wait_for_ring();
+    }
+    return 0;
+}
+
+static int ng_send_init_data(pvecinfoall data, int id, void *user_data) {
+    // Rows of the previous analysis must be read with the old width
+    while (!ring.is_empty()) {
+        wait_for_ring();
+    }
+
+    ring.next_generation();
+    row.assign(data->veccount, 0.0);
+    drop_rows = row.size() > ring.capacity();
+    if (drop_rows) {
+        send_line("out stderr sim_worker: result ring too small for " + std::to_string(row.size()) + " vectors");
+    }
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    printf("init %d\n", data->veccount);
+    for (int i = 0; i < data->veccount; i++) {
+        printf("%s\n", data->vecs[i]->vecname);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+static int ng_bg_thread_running(bool running, int id, void *user_data) {
+    return 0;
+}
+
+static void reply(bool success, const std::string &message) {
+    send_line(success ? std::string("ok") : "err " + message);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: sim_worker <shm-name> [ngspice-library]\n");
+        return 2;
+    }
+
+#ifndef _WIN32
+    host_pid = getppid();
+#endif
+
+    std::string error;
+    if (!shm.open(argv[1], error)) {
+        fprintf(stderr, "sim_worker: %s\n", error.c_str());
+        return 1;
+    }
+    if (!ring.attach(shm.get_memory())) {
+        fprintf(stderr, "sim_worker: %s is not a result ring\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<std::string> paths = NgspiceLibrary::default_paths();
+    if (argc > 2) {
+        paths.assign(1, argv[2]);
+    }
+    if (!ngspice.load(paths, error)) {
+        fprintf(stderr, "sim_worker: %s\n", error.c_str());
+        return 1;
+    }
+
+    int ret = ngspice.init(
+        ng_send_char,
+        ng_send_stat,
+        ng_controlled_exit,
+        ng_send_data,
+        ng_send_init_data,
+        ng_bg_thread_running,
+        nullptr
+    );
+    if (ret != 0) {
+        fprintf(stderr, "sim_worker: ngSpice_Init failed with code %d\n", ret);
+        return 1;
+    }
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (line == "quit") {
+            break;
+        } else if (line.compare(0, 5, "circ ") == 0) {
+            int count = atoi(line.c_str() + 5);
+            std::vector<std::string> netlist;
+            netlist.reserve(count);
+            for (int i = 0; i < count && std::getline(std::cin, line); i++) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                netlist.push_back(line);
+            }
+
+            std::vector<char*> circ_lines;
+            for (std::string &netlist_line : netlist) {
+                circ_lines.push_back((char*)netlist_line.c_str());
+            }
+            circ_lines.push_back(nullptr);  // Null terminator
+
+            bool success = ngspice.circ && ngspice.circ(circ_lines.data()) == 0;
+            reply(success, "failed to load netlist");
+        } else if (line.compare(0, 4, "cmd ") == 0) {
+            std::string command = line.substr(4);
+            bool success = ngspice.command((char*)command.c_str()) == 0;
+
+            // Replies must follow the last row of a command, so background
+            // commands (bg_run, bg_tran, ...) are waited for like foreground ones
+            if (success && command.compare(0, 3, "bg_") == 0 && ngspice.running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                while (ngspice.running()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    if (!host_alive()) {
+                        std::_Exit(1);
+                    }
+                }
+            }
+            reply(success, "command failed: " + command);
+        } else {
+            reply(false, "unknown request: " + line);
+        }
+    }
+
+    ngspice.command((char*)"quit");
+    return 0;
+}